@@ -1,5 +1,14 @@
 #!/bin/bash
 FLAGS="-Wall -Wextra -Werror"
-RAYLIB="-I./raylib-5.5/include -L./raylib-5.5/lib -l:libraylib.a -lm"
-FILES="src/main.c src/player.c"
+RAYLIB="-I./raylib-5.5/include -L./raylib-5.5/lib -l:libraylib.a -lm -pthread"
+FILES="src/main.c src/player.c src/collision.c src/raycast.c src/level.c src/tilemap.c src/trigger.c src/moving.c src/sap.c src/origin.c src/stream.c src/cache.c src/pool.c src/mem.c src/particles.c src/projectiles.c src/nav.c src/jobs.c"
+BENCH_FILES="src/bench.c src/player.c src/collision.c src/raycast.c src/level.c src/tilemap.c src/trigger.c src/moving.c src/sap.c src/compact.c src/origin.c src/stream.c src/cache.c src/pool.c src/mem.c src/particles.c src/projectiles.c src/nav.c src/jobs.c src/env.c"
+LEVELGEN_FILES="tools/levelgen.c src/level.c src/collision.c src/tilemap.c src/mem.c"
+
+# the built-in levels are compiled in as tables, see tools/levelgen.c
+mkdir -p src/generated
+gcc $FLAGS -O2 -o levelgen $LEVELGEN_FILES $RAYLIB || exit 1
+./levelgen default levels/default.lvl src/generated/level_default.h || exit 1
+
 gcc $FLAGS -o main $FILES $RAYLIB
+gcc $FLAGS -O2 -o bench $BENCH_FILES $RAYLIB
@@ -0,0 +1,1494 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "raylib.h"
+#include "game.h"
+#include "jobs.h"
+#include "env.h"
+#include "raycast.h"
+#include "sap.h"
+#include "compact.h"
+#include "origin.h"
+#include "stream.h"
+#include "cache.h"
+#include "pool.h"
+#include "mem.h"
+#include "particles.h"
+#include "projectiles.h"
+#include "nav.h"
+#include "tilemap.h"
+#include "utils.h"
+
+#define BENCH_FRAMES 10
+#define BENCH_DT (1.0f/60.0f)
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+// A big level made of rows of platforms with some walls between them, the
+// random generator is fixed so every run gets the same level.
+static void generate_level(Colliders *colliders, size_t count, unsigned int seed) {
+    srand(seed);
+    size_t perRow = 64;
+
+    for(size_t i = 0; i < count; i++) {
+        size_t row = i / perRow;
+        size_t col = i % perRow;
+
+        bool wall = rand() % 8 == 0;
+        da_append(colliders, ((Collider){
+            .x = col*400 + rand() % 150,
+            .y = row*300 + rand() % 100,
+            .width = wall ? 20 + rand() % 40 : 100 + rand() % 250,
+            .height = wall ? 150 + rand() % 200 : 20 + rand() % 40,
+            .category = COLLISION_LAYER_SOLID,
+            .mask = COLLISION_LAYER_ALL,
+        }));
+    }
+}
+
+typedef struct {
+    Vector2 *pos;
+    Vector2 *vel;
+    size_t count;
+    const Colliders *colliders;
+} Entities;
+
+static bool overlaps_level(const Colliders *colliders, Rectangle rec) {
+    for(size_t i = 0; i < colliders->count; i++) {
+        Collider c = colliders->items[i];
+        if(rec.x < c.x + c.width && rec.x + rec.width > c.x &&
+           rec.y < c.y + c.height && rec.y + rec.height > c.y) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void integrate_entities(void *data, size_t begin, size_t end) {
+    Entities *e = data;
+    for(size_t i = begin; i < end; i++) {
+        e->vel[i].y += 3000*BENCH_DT;
+        Vector2 next = { e->pos[i].x + e->vel[i].x*BENCH_DT, e->pos[i].y + e->vel[i].y*BENCH_DT };
+
+        if(overlaps_level(e->colliders, (Rectangle){next.x, next.y, 30, 60})) {
+            e->vel[i] = (Vector2){ -e->vel[i].x, 0 };
+        } else {
+            e->pos[i] = next;
+        }
+    }
+}
+
+static void bench_jobs_scaling(int maxThreads) {
+    Colliders colliders = {0};
+    generate_level(&colliders, 4096, 1);
+
+    Entities e = {
+        .count = 8192,
+        .colliders = &colliders,
+    };
+    e.pos = malloc(e.count*sizeof(Vector2));
+    e.vel = malloc(e.count*sizeof(Vector2));
+
+    double baseline = 0;
+    for(int threads = 1; threads <= maxThreads; threads++) {
+        srand(2);
+        for(size_t i = 0; i < e.count; i++) {
+            e.pos[i] = (Vector2){ rand() % 25600, rand() % 19200 };
+            e.vel[i] = (Vector2){ rand() % 600 - 300, 0 };
+        }
+
+        JobSystem *js = jobs_create(threads);
+
+        double start = bench_now();
+        for(int frame = 0; frame < BENCH_FRAMES; frame++) {
+            jobs_parallel_for(js, e.count, 64, integrate_entities, &e);
+        }
+        double ms = (bench_now() - start)*1000/BENCH_FRAMES;
+
+        jobs_destroy(js);
+
+        if(threads == 1) baseline = ms;
+        printf("{\"bench\":\"jobs_scaling\",\"threads\":%d,\"entities\":%zu,\"colliders\":%zu,"
+               "\"ms_per_frame\":%.3f,\"speedup\":%.2f}\n",
+               threads, e.count, colliders.count, ms, baseline/ms);
+    }
+
+    free(e.pos);
+    free(e.vel);
+    da_free(&colliders);
+}
+
+static void bench_env_steps(int maxThreads) {
+    Colliders level = {0};
+    generate_level(&level, 64, 3);
+
+    CollisionWorld world;
+    collision_world_build(&world, level.items, level.count);
+
+    size_t count = 4096;
+    int steps = 200;
+
+    uint8_t *actions = malloc(count*steps);
+    srand(4);
+    for(size_t i = 0; i < count*steps; i++) actions[i] = rand() % 16;
+
+    EnvConfig config = {
+        .spawn = { 100, 0 },
+        .goal = { 20000, 0 },
+        .goalRadius = 100,
+        .dt = 1.0f/60.0f,
+        .maxSteps = 1000,
+    };
+
+    for(int threads = 1; threads <= maxThreads; threads *= 2) {
+        JobSystem *js = jobs_create(threads);
+        Envs envs;
+        envs_create(&envs, count, &world, config, js);
+
+        double start = bench_now();
+        for(int s = 0; s < steps; s++) {
+            envs_step(&envs, &actions[s*count]);
+        }
+        double elapsed = bench_now() - start;
+
+        printf("{\"bench\":\"env_steps\",\"threads\":%d,\"envs\":%zu,\"steps\":%d,"
+               "\"env_steps_per_sec\":%.0f}\n",
+               threads, count, steps, count*steps/elapsed);
+
+        envs_destroy(&envs);
+        jobs_destroy(js);
+    }
+
+    free(actions);
+    collision_world_free(&world);
+    da_free(&level);
+}
+
+static void run_static_index(const char *name, const Colliders *level) {
+    double start = bench_now();
+    StaticIndex index;
+    static_index_build(&index, level->items, level->count);
+    double buildMs = (bench_now() - start)*1000;
+
+    size_t queries = 20000;
+    srand(6);
+    Rectangle *areas = malloc(queries*sizeof(Rectangle));
+    for(size_t i = 0; i < queries; i++) {
+        areas[i] = (Rectangle){ rand() % 25600, rand() % 307200, 60, 120 };
+    }
+
+    size_t linearHits = 0;
+    start = bench_now();
+    for(size_t i = 0; i < queries; i++) {
+        linearHits += overlaps_level(level, areas[i]);
+    }
+    double linearUs = (bench_now() - start)*1e6/queries;
+
+    CollisionFilter filter = { COLLISION_LAYER_PLAYER, COLLISION_LAYER_SOLID };
+    size_t indexHits = 0;
+    start = bench_now();
+    for(size_t i = 0; i < queries; i++) {
+        uint32_t hit;
+        indexHits += static_index_query(&index, areas[i], filter, &hit, 1);
+    }
+    double indexUs = (bench_now() - start)*1e6/queries;
+
+    printf("{\"bench\":\"%s\",\"colliders\":%zu,\"build_ms\":%.3f,"
+           "\"linear_us_per_query\":%.3f,\"index_us_per_query\":%.3f,\"same_hits\":%s}\n",
+           name, level->count, buildMs, linearUs, indexUs, linearHits == indexHits ? "true" : "false");
+
+    free(areas);
+    static_index_free(&index);
+}
+
+static void bench_static_index(void) {
+    Colliders level = {0};
+    generate_level(&level, 65536, 5);
+    run_static_index("static_index", &level);
+
+    // the same level with a few huge walls and a lot of tiny ledges, the
+    // sizes that a single cell size can't fit
+    srand(11);
+    for(size_t i = 0; i < level.count; i++) {
+        Collider *c = &level.items[i];
+        if(i % 64 == 0) {
+            c->width = 80;
+            c->height = 4000 + rand() % 4000;
+        } else if(i % 3 == 0) {
+            c->width = 8 + rand() % 8;
+            c->height = 8 + rand() % 8;
+        }
+    }
+    run_static_index("static_index_mixed", &level);
+
+    da_free(&level);
+}
+
+// Closest hit of a ray against every collider, to check the accelerated one
+// A hardware cache miss counter for this thread, -1 when perf events aren't
+// allowed (containers, perf_event_paranoid)
+static int cache_misses_open(void) {
+    struct perf_event_attr attr = {
+        .type = PERF_TYPE_HARDWARE,
+        .size = sizeof(attr),
+        .config = PERF_COUNT_HW_CACHE_MISSES,
+        .disabled = 1,
+        .exclude_kernel = 1,
+        .exclude_hv = 1,
+    };
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void cache_misses_start(int fd) {
+    if(fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+static long long cache_misses_stop(int fd) {
+    if(fd < 0) return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    long long count;
+    if(read(fd, &count, sizeof(count)) != sizeof(count)) return -1;
+    return count;
+}
+
+// Screen sized queries over a level whose colliders were appended in random
+// order, indexed as they came and sorted along the Z-order curve
+static void bench_static_order(void) {
+    Colliders level = {0};
+    generate_level(&level, 262144, 13);
+
+    srand(14);
+    for(size_t i = level.count - 1; i > 0; i--) {
+        size_t j = rand() % (i + 1);
+        Collider tmp = level.items[i];
+        level.items[i] = level.items[j];
+        level.items[j] = tmp;
+    }
+
+    size_t queries = 20000;
+    Rectangle *areas = malloc(queries*sizeof(Rectangle));
+    for(size_t i = 0; i < queries; i++) {
+        areas[i] = (Rectangle){ rand() % 25600, rand() % 1228800, 1280, 720 };
+    }
+
+    int fd = cache_misses_open();
+    CollisionFilter filter = { COLLISION_LAYER_PLAYER, COLLISION_LAYER_SOLID };
+    const char *orders[] = { "input", "morton" };
+    for(int o = 0; o < 2; o++) {
+        StaticIndex index;
+        if(o == 0) static_index_build_in_order(&index, level.items, level.count);
+        else static_index_build(&index, level.items, level.count);
+
+        // the colliders are read back like the broadphase callers do
+        size_t hits = 0;
+        double area = 0;
+        double start = bench_now();
+        cache_misses_start(fd);
+        for(size_t i = 0; i < queries; i++) {
+            uint32_t items[256];
+            size_t count = static_index_query(&index, areas[i], filter, items, 256);
+            for(size_t k = 0; k < count; k++) {
+                Collider c = static_index_get(&index, items[k]);
+                area += (double)c.width*c.height;
+            }
+            hits += count;
+        }
+        long long misses = cache_misses_stop(fd);
+        double us = (bench_now() - start)*1e6/queries;
+
+        printf("{\"bench\":\"static_order\",\"order\":\"%s\",\"colliders\":%zu,\"us_per_query\":%.3f,"
+               "\"hits_per_query\":%.1f,\"area\":%.0f,\"cache_misses_per_query\":",
+               orders[o], level.count, us, (double)hits/queries, area);
+        if(misses >= 0) printf("%.1f}\n", (double)misses/queries);
+        else printf("null}\n");
+
+        static_index_free(&index);
+    }
+
+    if(fd >= 0) close(fd);
+    free(areas);
+    da_free(&level);
+}
+
+static double colliders_checksum(const Collider *colliders, size_t count) {
+    double sum = 0;
+    for(size_t i = 0; i < count; i++) {
+        Collider c = colliders[i];
+        sum += (double)c.x*3 + (double)c.y*7 + (double)c.width*11 + (double)c.height*13;
+    }
+    return sum;
+}
+
+// The same level stored as floats in the static index and quantized, every
+// query has to return the same colliders
+static void bench_compact(void) {
+    Colliders level = {0};
+    generate_level(&level, 1048576, 15);
+    // a few off the integer grid, they stay floats
+    for(size_t i = 0; i < level.count; i += 997) level.items[i].x += 0.5f;
+
+    double start = bench_now();
+    CompactColliders cc;
+    compact_colliders_build(&cc, level.items, level.count);
+    double buildMs = (bench_now() - start)*1000;
+
+    CollisionWorld world;
+    collision_world_build(&world, level.items, level.count);
+
+    size_t queries = 20000;
+    srand(16);
+    Rectangle *areas = malloc(queries*sizeof(Rectangle));
+    for(size_t i = 0; i < queries; i++) {
+        areas[i] = (Rectangle){ rand() % 25600, rand() % 4915200, 1280, 720 };
+    }
+
+    CollisionFilter filter = { COLLISION_LAYER_PLAYER, COLLISION_LAYER_SOLID };
+    Collider found[256];
+    double indexTime = 0, compactTime = 0;
+    size_t mismatches = 0, hits = 0;
+    for(size_t i = 0; i < queries; i++) {
+        start = bench_now();
+        size_t expected = collision_query(&world, areas[i], filter, found, NULL, 256);
+        indexTime += bench_now() - start;
+        double expectedSum = colliders_checksum(found, expected);
+
+        start = bench_now();
+        size_t got = compact_colliders_query(&cc, areas[i], filter, found, 256);
+        compactTime += bench_now() - start;
+
+        if(got != expected || colliders_checksum(found, got) != expectedSum) mismatches++;
+        hits += got;
+    }
+
+    printf("{\"bench\":\"compact\",\"colliders\":%zu,\"fallback\":%zu,\"build_ms\":%.3f,"
+           "\"bytes_per_collider\":%.2f,\"float_bytes_per_collider\":%zu,\"hits_per_query\":%.1f,"
+           "\"index_us_per_query\":%.3f,\"compact_us_per_query\":%.3f,\"mismatches\":%zu}\n",
+           level.count, cc.fallback.count, buildMs, compact_colliders_bytes_per_item(&cc), 4*sizeof(float),
+           (double)hits/queries, indexTime*1e6/queries, compactTime*1e6/queries, mismatches);
+
+    free(areas);
+    collision_world_free(&world);
+    compact_colliders_free(&cc);
+    da_free(&level);
+}
+
+// A game far from the origin with 100k resident colliders, rebased back and
+// forth. A rebase has to fit in a frame with room to spare.
+static void bench_origin(void) {
+    Game game = {0};
+    Colliders level = {0};
+    generate_level(&level, 100000, 17);
+    for(size_t i = 0; i < level.count; i++) level.items[i].x += 1 << 20;
+    collision_world_build(&game.collision, level.items, level.count);
+    tilemap_init(&game.tiles, 1024, 256, 32, (Vector2){ 1 << 20, 0 });
+    game.collision.tiles = &game.tiles;
+
+    srand(18);
+    for(size_t i = 0; i < 1000; i++) {
+        Vector2 start = { (1 << 20) + rand() % 25600, rand() % 300000 };
+        Vector2 path[] = { start, { start.x + 300, start.y } };
+        moving_platforms_add(&game.moving, &game.collision, path, 2, (Vector2){ 120, 20 }, 100);
+        trigger_set_add(&game.triggers, (Rectangle){ start.x, start.y - 200, 100, 100 }, TRIGGER_ROOM);
+    }
+    trigger_set_build(&game.triggers);
+    game.player.pos = (Vector2){ (1 << 20) + 5000, 1000 };
+
+    CollisionFilter filter = { COLLISION_LAYER_PLAYER, COLLISION_LAYER_SOLID };
+    Rectangle area = { (1 << 20) + 4000, 0, 20000, 200000 };
+    Collider found[4096];
+    size_t before = collision_query(&game.collision, area, filter, found, NULL, 4096);
+    double beforeSum = colliders_checksum(found, before);
+
+    // the first one brings the player near the origin, the next ones go back
+    // and forth by a quantum
+    double start = bench_now();
+    bool rebased = origin_rebase(&game);
+    double firstMs = (bench_now() - start)*1000;
+
+    int shifts = 100;
+    start = bench_now();
+    for(int i = 0; i < shifts; i++) {
+        origin_shift(&game, (Vector2){ i % 2 == 0 ? ORIGIN_QUANTUM : -ORIGIN_QUANTUM, 0 });
+    }
+    double shiftMs = (bench_now() - start)*1000/shifts;
+
+    // an even number of shifts, the net one is the first rebase
+    float shift = (float)-game.originX;
+    area.x += shift;
+    size_t after = collision_query(&game.collision, area, filter, found, NULL, 4096);
+    for(size_t i = 0; i < after; i++) found[i].x -= shift;
+    bool same = rebased && after == before && colliders_checksum(found, after) == beforeSum;
+
+    printf("{\"bench\":\"origin\",\"colliders\":%zu,\"dynamics\":%zu,\"triggers\":%zu,"
+           "\"first_rebase_ms\":%.3f,\"ms_per_rebase\":%.3f,\"origin_x\":%lld,\"same_results\":%s}\n",
+           level.count, game.collision.dynamics.count, game.triggers.triggers.count, firstMs, shiftMs,
+           (long long)game.originX, same ? "true" : "false");
+
+    moving_platforms_free(&game.moving);
+    trigger_set_free(&game.triggers);
+    tilemap_free(&game.tiles);
+    collision_world_free(&game.collision);
+    da_free(&level);
+}
+
+// The player runs right on a long floor, dashing and jumping, over a level
+// streamed in 256px chunks with a budget of one load per tick
+static void bench_stream(void) {
+    Collider floor = {
+        .x = 0, .y = 2048, .width = 4096*512, .height = 64,
+        .category = COLLISION_LAYER_SOLID, .mask = COLLISION_LAYER_ALL,
+    };
+    CollisionWorld world;
+    collision_world_build(&world, &floor, 1);
+
+    // a jump or a dash from the floor has to be predicted like it's flown
+    float maxError = 0;
+    int predicted = STREAM_MAX_PREDICTION; // ticks of the shortest arc
+    for(int run = 0; run < 4; run++) {
+        Player player = {
+            .pos = { 1000, 2048 - 120 },
+            .isOnFloor = true,
+            .dir = PLAYER_DIR_RIGHT,
+            .riding = COLLIDER_REF_NONE,
+        };
+        PlayerInput input = { .right = run % 2 == 0, .jumpPressed = true, .dashPressed = run >= 2 };
+
+        PlayerArc arc;
+        player_arc(&player, input, BENCH_DT, STREAM_MAX_PREDICTION, &arc);
+        if(arc.ticks < predicted) predicted = arc.ticks;
+        for(int t = 1; t <= arc.ticks; t++) {
+            player_step_free(&player, input, BENCH_DT);
+            input.jumpPressed = false;
+            input.dashPressed = false;
+            Vector2 at = player_arc_at(&arc, t);
+            maxError = fmaxf(maxError, fmaxf(fabsf(at.x - player.pos.x), fabsf(at.y - player.pos.y)));
+        }
+    }
+    printf("{\"bench\":\"stream_predict\",\"ticks\":%d,\"max_error\":%.3f}\n", predicted, maxError);
+
+    // without prediction a small radius is loaded too late when dashing
+    for(int run = 0; run < 4; run++) {
+        ChunkStream stream;
+        StreamConfig config = {
+            .chunkSize = 256,
+            .loadRadius = run / 2,
+            .evictRadius = 4,
+            .horizon = run % 2 == 0 ? 0 : 0.5f,
+            .loadsPerTick = 1,
+        };
+        stream_init(&stream, config, 8192, 32, (Vector2){ 0, 0 }, NULL, NULL, NULL);
+
+        Player player = {
+            .pos = { 1000, 2048 - 120 },
+            .dir = PLAYER_DIR_RIGHT,
+            .riding = COLLIDER_REF_NONE,
+        };
+
+        int ticks = 600;
+        size_t maxQueue = 0;
+        double start = bench_now();
+        for(int t = 0; t < ticks; t++) {
+            PlayerInput input = {
+                .right = true,
+                .dashPressed = t % 7 == 0,
+                .jumpPressed = t % 45 == 10,
+                .jumpReleased = t % 45 == 25,
+            };
+            stream_update(&stream, &player, input, BENCH_DT);
+            player_step(&player, &world, input, BENCH_DT);
+            if(stream.queue.count > maxQueue) maxQueue = stream.queue.count;
+        }
+        double usPerTick = (bench_now() - start)*1e6/ticks;
+
+        printf("{\"bench\":\"stream\",\"load_radius\":%d,\"horizon\":%.2f,\"distance\":%.0f,\"loads\":%zu,\"prefetched\":%zu,"
+               "\"late_loads\":%zu,\"misses\":%zu,\"evictions\":%zu,\"max_queue\":%zu,\"us_per_tick\":%.3f}\n",
+               config.loadRadius, config.horizon, player.pos.x - 1000, stream.loads, stream.prefetched, stream.lateLoads,
+               stream.misses, stream.evictions, maxQueue, usPerTick);
+
+        stream_free(&stream);
+    }
+
+    collision_world_free(&world);
+}
+
+// A big level built from its platforms on the first launch and mapped from
+// the cache on the next one, both have to answer the same
+static void bench_level_cache(void) {
+    Colliders level = {0};
+    generate_level(&level, 262144, 19);
+    Rectangle *rects = malloc(level.count*sizeof(Rectangle));
+    for(size_t i = 0; i < level.count; i++) {
+        Collider c = level.items[i];
+        rects[i] = (Rectangle){ c.x, c.y, c.width, c.height };
+    }
+
+    char dir[] = "/tmp/level-cache-XXXXXX";
+    if(mkdtemp(dir) == NULL) {
+        free(rects);
+        da_free(&level);
+        return;
+    }
+
+    StaticIndex built, mapped;
+    double start = bench_now();
+    bool coldHit = level_cache_load(&built, dir, rects, level.count);
+    double coldMs = (bench_now() - start)*1000;
+
+    start = bench_now();
+    bool warmHit = level_cache_load(&mapped, dir, rects, level.count);
+    double warmMs = (bench_now() - start)*1000;
+
+    CollisionFilter filter = { COLLISION_LAYER_PLAYER, COLLISION_LAYER_SOLID };
+    Collider a[256], b[256];
+    size_t mismatches = 0;
+    srand(20);
+    for(int i = 0; i < 2000; i++) {
+        Rectangle area = { rand() % 25600, rand() % 1228800, 1280, 720 };
+        size_t na = static_index_query_colliders(&built, area, filter, a, 256);
+        size_t nb = static_index_query_colliders(&mapped, area, filter, b, 256);
+        if(na != nb || memcmp(a, b, na*sizeof(Collider)) != 0) mismatches++;
+    }
+
+    // the tail of the file holds the items of the coarsest grid, out of
+    // range ones must send the load back to a rebuild
+    char path[512];
+    StaticIndex rebuilt = {0};
+    bool corruptHit = true;
+    FILE *f = NULL;
+    DIR *d = opendir(dir);
+    struct dirent *entry;
+    while(d != NULL && (entry = readdir(d)) != NULL) {
+        if(strstr(entry->d_name, ".lvc") == NULL) continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        f = fopen(path, "r+b");
+        break;
+    }
+    if(d != NULL) closedir(d);
+    if(f != NULL) {
+        uint32_t garbage[64];
+        memset(garbage, 0xff, sizeof(garbage));
+        fseek(f, -(long)sizeof(garbage), SEEK_END);
+        fwrite(garbage, sizeof(garbage), 1, f);
+        fclose(f);
+        corruptHit = level_cache_load(&rebuilt, dir, rects, level.count);
+        for(int i = 0; i < 2000; i++) {
+            Rectangle area = { rand() % 25600, rand() % 1228800, 1280, 720 };
+            size_t na = static_index_query_colliders(&built, area, filter, a, 256);
+            size_t nb = static_index_query_colliders(&rebuilt, area, filter, b, 256);
+            if(na != nb || memcmp(a, b, na*sizeof(Collider)) != 0) mismatches++;
+        }
+    }
+
+    printf("{\"bench\":\"level_cache\",\"platforms\":%zu,\"colliders\":%zu,\"file_bytes\":%zu,"
+           "\"cold_hit\":%s,\"cold_ms\":%.3f,\"warm_hit\":%s,\"warm_ms\":%.3f,\"corrupt_hit\":%s,"
+           "\"mismatches\":%zu}\n",
+           level.count, mapped.count, mapped.mappedSize, coldHit ? "true" : "false", coldMs,
+           warmHit ? "true" : "false", warmMs, corruptHit ? "true" : "false", mismatches);
+
+    static_index_free(&built);
+    static_index_free(&mapped);
+    static_index_free(&rebuilt);
+
+    snprintf(path, sizeof(path), "rm -rf %s", dir);
+    if(system(path) != 0) fprintf(stderr, "could not remove %s\n", dir);
+
+    free(rects);
+    da_free(&level);
+}
+
+typedef struct {
+    Vector2 pos;
+    Vector2 vel;
+    uint32_t id;
+    float life;
+} BenchEntity;
+
+// Random spawns and despawns around half the capacity, against a malloc and
+// free per entity. Every stale handle has to be refused and every live one
+// has to find its own entity after the moves.
+static void bench_pool(void) {
+    uint32_t capacity = 65536;
+    size_t ops = 4000000;
+
+    Pool pool;
+    pool_init(&pool, sizeof(BenchEntity), capacity, MEM_TAG_SCRATCH);
+    PoolHandle *live = malloc(capacity*sizeof(PoolHandle));
+    PoolHandle *dead = malloc(capacity*sizeof(PoolHandle));
+    BenchEntity **ptrs = malloc(capacity*sizeof(BenchEntity*));
+    size_t liveCount = 0, deadCount = 0, errors = 0;
+
+    // rolled up front, both runs see the same sequence without timing rand
+    uint32_t *rolls = malloc(ops*sizeof(uint32_t));
+    srand(21);
+    for(size_t op = 0; op < ops; op++) rolls[op] = rand();
+
+    double start = bench_now();
+    for(size_t op = 0; op < ops; op++) {
+        bool spawn = liveCount == 0 || (liveCount < capacity && rolls[op] % 100 < (liveCount < capacity/2 ? 60 : 40));
+        if(spawn) {
+            PoolHandle h = pool_alloc(&pool);
+            BenchEntity *e = pool_get(&pool, h);
+            e->id = op;
+            live[liveCount++] = h;
+        } else {
+            size_t k = (rolls[op] >> 8) % liveCount;
+            PoolHandle h = live[k];
+            if(!pool_release(&pool, h)) errors++;
+            live[k] = live[--liveCount];
+            // only the recent ones, older handles could see their generation wrap
+            dead[deadCount++ % capacity] = h;
+        }
+    }
+    double poolMs = (bench_now() - start)*1000;
+
+    if(deadCount > capacity) deadCount = capacity;
+    for(size_t k = 0; k < deadCount; k++) {
+        if(pool_get(&pool, dead[k]) != NULL || pool_release(&pool, dead[k])) errors++;
+    }
+    uint32_t *ids = malloc(capacity*sizeof(uint32_t));
+    for(uint32_t i = 0; i < pool.count; i++) {
+        BenchEntity *e = pool_at(&pool, i);
+        BenchEntity *viaHandle = pool_get(&pool, pool_handle_at(&pool, i));
+        if(e != viaHandle) errors++;
+    }
+    for(size_t k = 0; k < liveCount; k++) ids[k] = ((BenchEntity*)pool_get(&pool, live[k]))->id;
+    if(pool.count != liveCount) errors++;
+
+    // dense iteration over what's left
+    start = bench_now();
+    for(int pass = 0; pass < 100; pass++) {
+        BenchEntity *entities = (BenchEntity*)pool.items;
+        for(uint32_t i = 0; i < pool.count; i++) {
+            entities[i].pos.x += entities[i].vel.x*BENCH_DT;
+            entities[i].pos.y += entities[i].vel.y*BENCH_DT;
+        }
+    }
+    double iterateUs = (bench_now() - start)*1e6/100;
+
+    // the same churn with an allocation per entity
+    size_t ptrCount = 0;
+    start = bench_now();
+    for(size_t op = 0; op < ops; op++) {
+        bool spawn = ptrCount == 0 || (ptrCount < capacity && rolls[op] % 100 < (ptrCount < capacity/2 ? 60 : 40));
+        if(spawn) {
+            BenchEntity *e = calloc(1, sizeof(BenchEntity));
+            e->id = op;
+            ptrs[ptrCount++] = e;
+        } else {
+            size_t k = (rolls[op] >> 8) % ptrCount;
+            free(ptrs[k]);
+            ptrs[k] = ptrs[--ptrCount];
+        }
+    }
+    double mallocMs = (bench_now() - start)*1000;
+
+    start = bench_now();
+    for(int pass = 0; pass < 100; pass++) {
+        for(size_t k = 0; k < ptrCount; k++) {
+            ptrs[k]->pos.x += ptrs[k]->vel.x*BENCH_DT;
+            ptrs[k]->pos.y += ptrs[k]->vel.y*BENCH_DT;
+        }
+    }
+    double iterateMallocUs = (bench_now() - start)*1e6/100;
+    for(size_t k = 0; k < ptrCount; k++) {
+        if(ptrs[k]->id != ids[k]) errors++;
+        free(ptrs[k]);
+    }
+
+    printf("{\"bench\":\"pool\",\"capacity\":%u,\"ops\":%zu,\"live\":%u,\"pool_ns_per_op\":%.1f,"
+           "\"malloc_ns_per_op\":%.1f,\"iterate_us\":%.1f,\"iterate_malloc_us\":%.1f,\"stale_checked\":%zu,\"errors\":%zu}\n",
+           capacity, ops, pool.count, poolMs*1e6/ops, mallocMs*1e6/ops, iterateUs, iterateMallocUs, deadCount, errors);
+
+    free(rolls);
+    free(ids);
+    free(ptrs);
+    free(dead);
+    free(live);
+    pool_free(&pool);
+}
+
+static float raycast_reference(const Colliders *level, RayCast ray) {
+    float len = sqrtf(ray.dir.x*ray.dir.x + ray.dir.y*ray.dir.y);
+    float dx = ray.dir.x/len, dy = ray.dir.y/len;
+    float best = ray.maxDistance;
+
+    for(size_t i = 0; i < level->count; i++) {
+        Collider c = level->items[i];
+        float tx1 = (c.x - ray.origin.x)/dx, tx2 = (c.x + c.width - ray.origin.x)/dx;
+        float ty1 = (c.y - ray.origin.y)/dy, ty2 = (c.y + c.height - ray.origin.y)/dy;
+        float tNear = fmaxf(fmaxf(fminf(tx1, tx2), fminf(ty1, ty2)), 0);
+        float tFar = fminf(fmaxf(tx1, tx2), fmaxf(ty1, ty2));
+        if(tNear <= tFar && tNear < best) best = tNear;
+    }
+
+    return best;
+}
+
+static void bench_raycast(int maxThreads) {
+    Colliders level = {0};
+    generate_level(&level, 65536, 7);
+
+    CollisionWorld world;
+    collision_world_build(&world, level.items, level.count);
+
+    size_t count = 200000;
+    RayCast *rays = malloc(count*sizeof(RayCast));
+    RayHit *hits = malloc(count*sizeof(RayHit));
+
+    srand(8);
+    for(size_t i = 0; i < count; i++) {
+        float angle = (rand() % 3600)*PI/1800;
+        rays[i] = (RayCast) {
+            .origin = { rand() % 25600, rand() % 307200 },
+            .dir = { cosf(angle), sinf(angle) },
+            .maxDistance = 2000,
+            .filter = { COLLISION_LAYER_ENEMY, COLLISION_LAYER_SOLID },
+        };
+    }
+
+    double start = bench_now();
+    raycast_batch(&world, rays, hits, count);
+    double serial = bench_now() - start;
+
+    size_t checked = 2000, mismatches = 0;
+    for(size_t i = 0; i < checked; i++) {
+        if(fabsf(raycast_reference(&level, rays[i]) - hits[i].distance) > 0.01f) mismatches++;
+    }
+
+    JobSystem *js = jobs_create(maxThreads);
+    start = bench_now();
+    raycast_batch_parallel(js, &world, rays, hits, count);
+    double parallel = bench_now() - start;
+    jobs_destroy(js);
+
+    // tiles over the start of the level, every solid one is also a box for
+    // the reference
+    Tilemap tiles;
+    tilemap_init(&tiles, 400, 200, 32, (Vector2){ 0, 0 });
+    Colliders withTiles = {0};
+    for(size_t i = 0; i < level.count; i++) da_append(&withTiles, level.items[i]);
+    for(int row = 0; row < tiles.rows; row++) {
+        for(int col = 0; col < tiles.cols; col++) {
+            if(rand() % 10 != 0) continue;
+            tilemap_set(&tiles, col, row, true);
+            da_append(&withTiles, ((Collider){ col*32.0f, row*32.0f, 32, 32, COLLISION_LAYER_SOLID, COLLISION_LAYER_ALL }));
+        }
+    }
+    world.tiles = &tiles;
+
+    size_t tileRays = 2000, tileMismatches = 0;
+    for(size_t i = 0; i < tileRays; i++) {
+        float angle = (rand() % 3600)*PI/1800;
+        rays[i] = (RayCast) {
+            .origin = { rand() % 12800 + 0.5f, rand() % 6400 + 0.5f },
+            .dir = { cosf(angle), sinf(angle) },
+            .maxDistance = 2000,
+            .filter = { COLLISION_LAYER_ENEMY, COLLISION_LAYER_SOLID },
+        };
+    }
+    raycast_batch(&world, rays, hits, tileRays);
+    for(size_t i = 0; i < tileRays; i++) {
+        if(fabsf(raycast_reference(&withTiles, rays[i]) - hits[i].distance) > 0.01f) tileMismatches++;
+    }
+    world.tiles = NULL;
+    tilemap_free(&tiles);
+    da_free(&withTiles);
+
+    // moving boxes go through the hash of the world
+    Colliders withDynamics = {0};
+    for(size_t i = 0; i < level.count; i++) da_append(&withDynamics, level.items[i]);
+    for(int i = 0; i < 4000; i++) {
+        Collider c = { rand() % 25600, rand() % 25600, 20 + rand() % 300, 20 + rand() % 100,
+                       COLLISION_LAYER_SOLID, COLLISION_LAYER_ALL };
+        collision_world_add_dynamic(&world, c);
+        da_append(&withDynamics, c);
+    }
+
+    size_t dynamicRays = 2000, dynamicMismatches = 0;
+    for(size_t i = 0; i < dynamicRays; i++) {
+        float angle = (rand() % 3600)*PI/1800;
+        rays[i] = (RayCast) {
+            .origin = { rand() % 25600 + 0.5f, rand() % 25600 + 0.5f },
+            .dir = { cosf(angle), sinf(angle) },
+            .maxDistance = 2000,
+            .filter = { COLLISION_LAYER_ENEMY, COLLISION_LAYER_SOLID },
+        };
+    }
+    start = bench_now();
+    raycast_batch(&world, rays, hits, dynamicRays);
+    double dynamicTime = bench_now() - start;
+    for(size_t i = 0; i < dynamicRays; i++) {
+        if(fabsf(raycast_reference(&withDynamics, rays[i]) - hits[i].distance) > 0.01f) dynamicMismatches++;
+    }
+    da_free(&withDynamics);
+
+    printf("{\"bench\":\"raycast\",\"colliders\":%zu,\"rays\":%zu,\"rays_per_sec\":%.0f,"
+           "\"threads\":%d,\"parallel_rays_per_sec\":%.0f,\"mismatches\":%zu,\"tile_mismatches\":%zu,"
+           "\"dynamic_rays_per_sec\":%.0f,\"dynamic_mismatches\":%zu}\n",
+           level.count, count, count/serial, maxThreads, count/parallel, mismatches, tileMismatches,
+           dynamicRays/dynamicTime, dynamicMismatches);
+
+    free(rays);
+    free(hits);
+    collision_world_free(&world);
+    da_free(&level);
+}
+
+// Thousands of platforms going back and forth over a big static level, with
+// a query per platform to check the dynamic index against a linear scan
+static void bench_moving_platforms(void) {
+    Colliders level = {0};
+    generate_level(&level, 65536, 9);
+
+    CollisionWorld world;
+    collision_world_build(&world, level.items, level.count);
+
+    MovingPlatforms mp = {0};
+    size_t count = 10000;
+    srand(10);
+    for(size_t i = 0; i < count; i++) {
+        Vector2 start = { rand() % 25600, rand() % 307200 };
+        Vector2 path[] = { start, { start.x + rand() % 400, start.y + rand() % 400 } };
+        moving_platforms_add(&mp, &world, path, 2, (Vector2){ 120, 20 }, 50 + rand() % 250);
+    }
+
+    int ticks = 600;
+    size_t rebinned = 0;
+    double start = bench_now();
+    for(int t = 0; t < ticks; t++) {
+        collision_world_begin_tick(&world);
+        moving_platforms_update(&mp, &world, BENCH_DT);
+        rebinned += world.dynamics.rebinned;
+    }
+    double tickMs = (bench_now() - start)*1000/ticks;
+
+    CollisionFilter filter = { COLLISION_LAYER_PLAYER, COLLISION_LAYER_SOLID };
+    size_t mismatches = 0;
+    for(size_t i = 0; i < count; i += 10) {
+        MovingPlatform p = mp.platforms.items[i];
+        Rectangle area = { p.pos.x - 100, p.pos.y - 100, p.size.x + 200, p.size.y + 200 };
+
+        size_t expected = 0;
+        for(size_t j = 0; j < world.dynamics.count; j++) {
+            Collider c = world.dynamics.items[j];
+            expected += CheckCollisionRecs(area, (Rectangle){ c.x, c.y, c.width, c.height });
+        }
+
+        Collider found[256];
+        ColliderRef refs[256];
+        size_t got = 0, hits = collision_query(&world, area, filter, found, refs, 256);
+        for(size_t k = 0; k < hits; k++) got += (refs[k] & COLLIDER_REF_DYNAMIC) != 0;
+        if(got != expected) mismatches++;
+    }
+
+    printf("{\"bench\":\"moving_platforms\",\"platforms\":%zu,\"colliders\":%zu,\"ms_per_tick\":%.3f,"
+           "\"rebinned_per_tick\":%.1f,\"mismatches\":%zu}\n",
+           count, level.count, tickMs, (double)rebinned/ticks, mismatches);
+
+    moving_platforms_free(&mp);
+    collision_world_free(&world);
+    da_free(&level);
+}
+
+static size_t linear_pairs(const Collider *bodies, size_t count) {
+    size_t pairs = 0;
+    for(size_t i = 0; i < count; i++) {
+        for(size_t j = i + 1; j < count; j++) {
+            pairs += CheckCollisionRecs((Rectangle){ bodies[i].x, bodies[i].y, bodies[i].width, bodies[i].height },
+                                        (Rectangle){ bodies[j].x, bodies[j].y, bodies[j].width, bodies[j].height });
+        }
+    }
+    return pairs;
+}
+
+// Entities wandering in a closed room, every one against every other. The
+// sweep and prune keeps its pairs between ticks, the linear pass redoes all.
+static void bench_sap(void) {
+    size_t count = 4096;
+    Collider *bodies = malloc(count*sizeof(Collider));
+    Vector2 *vel = malloc(count*sizeof(Vector2));
+    float roomW = 8000, roomH = 4000;
+
+    SweepAndPrune sap = {0};
+    srand(12);
+    for(size_t i = 0; i < count; i++) {
+        bodies[i] = (Collider) {
+            .x = rand() % (int)roomW,
+            .y = rand() % (int)roomH,
+            .width = 30,
+            .height = 60,
+            .category = COLLISION_LAYER_ENEMY,
+            .mask = COLLISION_LAYER_ALL,
+        };
+        vel[i] = (Vector2){ rand() % 400 - 200, rand() % 400 - 200 };
+        sap_add(&sap, bodies[i]);
+    }
+    sap_update(&sap);
+    size_t pairs = sap.added.count;
+
+    int ticks = 120;
+    size_t swaps = 0, churn = 0;
+    double sapTime = 0, linearTime = 0;
+    bool same = true;
+    for(int t = 0; t < ticks; t++) {
+        for(size_t i = 0; i < count; i++) {
+            Collider *b = &bodies[i];
+            b->x += vel[i].x*BENCH_DT;
+            b->y += vel[i].y*BENCH_DT;
+            if(b->x < 0 || b->x > roomW) vel[i].x = -vel[i].x;
+            if(b->y < 0 || b->y > roomH) vel[i].y = -vel[i].y;
+            sap_set(&sap, i, *b);
+        }
+
+        double start = bench_now();
+        sap_update(&sap);
+        sapTime += bench_now() - start;
+        pairs += sap.added.count;
+        pairs -= sap.removed.count;
+        swaps += sap.swaps;
+        churn += sap.added.count + sap.removed.count;
+
+        // the linear pass is slow, only some ticks are timed and checked
+        if(t % 20 == 0) {
+            start = bench_now();
+            size_t expected = linear_pairs(bodies, count);
+            linearTime += bench_now() - start;
+            if(expected != pairs) same = false;
+        }
+    }
+
+    printf("{\"bench\":\"sap\",\"bodies\":%zu,\"pairs\":%zu,\"sap_ms_per_tick\":%.3f,"
+           "\"linear_ms_per_tick\":%.3f,\"swaps_per_tick\":%.0f,\"pair_changes_per_tick\":%.1f,\"same_pairs\":%s}\n",
+           count, pairs, sapTime*1000/ticks, linearTime*1000/(ticks/20), (double)swaps/ticks,
+           (double)churn/ticks, same ? "true" : "false");
+
+    sap_free(&sap);
+    free(bodies);
+    free(vel);
+}
+
+typedef struct {
+    Vector2 pos;
+    Vector2 vel;
+    float life;
+    float invLife;
+    float size;
+    Color color;
+} BenchParticle;
+
+// 100k live particles kept alive by a burst every tick, against the same
+// update on an array of structs. Both are seeded alike, so they must end with
+// the same count and about the same positions. A third copy runs on the job
+// system and must match the serial one exactly.
+static void bench_particles(int maxThreads) {
+    size_t live = 100000;
+    int ticks = 600;
+    ParticleEmitter emitter = {
+        .velocity = { 0, -200 },
+        .velocitySpread = { 300, 200 },
+        .offsetSpread = { 2000, 1000 },
+        .life = 1.0f,
+        .lifeSpread = 0.5f,
+        .size = 4,
+        .color = WHITE,
+    };
+
+    ParticleSystem ps, ref, par;
+    particles_init(&ps, live*2, 600, 3);
+    particles_init(&ref, live*2, 600, 3);
+    particles_init(&par, live*2, 600, 3);
+    particles_emit(&ps, &emitter, (Vector2){ 0, 0 }, live);
+    particles_emit(&ref, &emitter, (Vector2){ 0, 0 }, live);
+    particles_emit(&par, &emitter, (Vector2){ 0, 0 }, live);
+    JobSystem *js = jobs_create(maxThreads);
+
+    BenchParticle *aos = malloc(ref.capacity*sizeof(BenchParticle));
+    size_t aosCount = 0;
+
+    double soaTime = 0, aosTime = 0, parTime = 0, maxTickMs = 0;
+    size_t spawned = 0;
+    for(int t = 0; t < ticks; t++) {
+        // the dead of the last tick come back, the count stays around live
+        size_t burst = live > ps.count ? live - ps.count : 0;
+        spawned += burst;
+
+        double start = bench_now();
+        particles_emit(&ps, &emitter, (Vector2){ 0, 0 }, burst);
+        particles_update(&ps, BENCH_DT);
+        double tick = bench_now() - start;
+        soaTime += tick;
+        if(tick*1000 > maxTickMs) maxTickMs = tick*1000;
+
+        // the same particles on the job system, they only differ in who
+        // integrates which group so the lanes stay bit identical
+        start = bench_now();
+        particles_emit(&par, &emitter, (Vector2){ 0, 0 }, burst);
+        particles_update_parallel(js, &par, BENCH_DT);
+        parTime += bench_now() - start;
+
+        // the reference takes the same particles from a second system
+        particles_emit(&ref, &emitter, (Vector2){ 0, 0 }, burst);
+        for(size_t i = aosCount; i < ref.count; i++) {
+            aos[i] = (BenchParticle) {
+                .pos = { ref.x[i], ref.y[i] },
+                .vel = { ref.vx[i], ref.vy[i] },
+                .life = ref.life[i],
+                .invLife = ref.invLife[i],
+                .size = ref.size[i],
+                .color = ref.color[i],
+            };
+        }
+        aosCount = ref.count;
+
+        start = bench_now();
+        float damp = fmaxf(1 - ref.drag*BENCH_DT, 0);
+        for(size_t i = 0; i < aosCount;) {
+            BenchParticle *p = &aos[i];
+            p->vel.x *= damp;
+            p->vel.y = p->vel.y*damp + ref.gravity*BENCH_DT;
+            p->pos.x += p->vel.x*BENCH_DT;
+            p->pos.y += p->vel.y*BENCH_DT;
+            p->life -= BENCH_DT;
+            if(p->life <= 0) *p = aos[--aosCount];
+            else i++;
+        }
+        aosTime += bench_now() - start;
+        ref.count = aosCount;
+    }
+
+    double sumSoa = 0, sumAos = 0;
+    for(size_t i = 0; i < ps.count; i++) sumSoa += ps.x[i] + ps.y[i];
+    for(size_t i = 0; i < aosCount; i++) sumAos += aos[i].pos.x + aos[i].pos.y;
+    bool same = ps.count == aosCount && fabs(sumSoa - sumAos) <= 1e-4*fabs(sumAos) + 1;
+    bool parSame = par.count == ps.count && memcmp(par.x, ps.x, ps.count*sizeof(float)) == 0 &&
+                   memcmp(par.y, ps.y, ps.count*sizeof(float)) == 0;
+
+    printf("{\"bench\":\"particles\",\"live\":%zu,\"ticks\":%d,\"spawned_per_tick\":%.0f,"
+           "\"soa_ms_per_tick\":%.3f,\"soa_max_ms\":%.3f,\"aos_ms_per_tick\":%.3f,\"same\":%s,"
+           "\"threads\":%d,\"parallel_ms_per_tick\":%.3f,\"parallel_same\":%s}\n",
+           ps.count, ticks, (double)spawned/ticks, soaTime*1000/ticks, maxTickMs, aosTime*1000/ticks,
+           same ? "true" : "false", jobs_thread_count(js), parTime*1000/ticks, parSame ? "true" : "false");
+
+    jobs_destroy(js);
+    free(aos);
+    particles_free(&par);
+    particles_free(&ref);
+    particles_free(&ps);
+}
+
+// What a tick of projectiles_update should hit, tested against everything
+// by brute force from the state before the tick
+static size_t projectile_reference_hits(const Projectiles *p, const Collider *level, size_t levelCount,
+                                        Rectangle player, float dt, size_t *playerHits) {
+    float half = PROJECTILE_GRID_DIM*PROJECTILE_CELL_SIZE*0.5f;
+    float gridX = player.x + player.width*0.5f - half;
+    float gridY = player.y + player.height*0.5f - half;
+    Rectangle area = { gridX, gridY, 2*half, 2*half };
+
+    size_t hits = 0;
+    *playerHits = 0;
+    for(size_t i = 0; i < p->count; i++) {
+        float x = p->x[i] + p->vx[i]*dt, y = p->y[i] + p->vy[i]*dt, r = p->radius[i];
+        float fx = (x - gridX)*(1.0f/PROJECTILE_CELL_SIZE), fy = (y - gridY)*(1.0f/PROJECTILE_CELL_SIZE);
+        if(p->life[i] - dt <= 0 || fx < 0 || fx >= PROJECTILE_GRID_DIM || fy < 0 || fy >= PROJECTILE_GRID_DIM) continue;
+
+        if(x - r < player.x + player.width && x + r > player.x && y - r < player.y + player.height && y + r > player.y) {
+            hits++;
+            (*playerHits)++;
+            continue;
+        }
+        for(size_t c = 0; c < levelCount; c++) {
+            Collider l = level[c];
+            bool inArea = l.x < area.x + area.width && l.x + l.width > area.x &&
+                          l.y < area.y + area.height && l.y + l.height > area.y;
+            if(inArea && x - r < l.x + l.width && x + r > l.x && y - r < l.y + l.height && y + r > l.y) {
+                hits++;
+                break;
+            }
+        }
+    }
+    return hits;
+}
+
+// 100k projectiles crossing a level around the player at 240 Hz, the dead
+// ones are replaced every tick. Some ticks are checked by brute force, every
+// tick against a copy updated on the job system.
+static void bench_projectiles(int maxThreads) {
+    size_t live = 100000;
+    int ticks = 960;
+    int warmup = 240; // the first ticks fault in the lanes and aren't timed
+    float dt = 1.0f/240;
+
+    Colliders level = {0};
+    generate_level(&level, 4096, 22);
+    CollisionWorld world;
+    collision_world_build(&world, level.items, level.count);
+
+    // par gets the same spawns and runs on the job system
+    Projectiles p, par;
+    projectiles_init(&p, live);
+    projectiles_init(&par, live);
+    JobSystem *js = jobs_create(maxThreads);
+    Rectangle player = { 12800, 9600, 60, 120 };
+
+    srand(23);
+    double time = 0, parTime = 0, maxTickMs = 0;
+    size_t hits = 0, playerHits = 0, binned = 0, mismatches = 0, checked = 0, parMismatches = 0, overBudget = 0;
+    for(int t = -warmup; t < ticks; t++) {
+        if(t == 0) {
+            time = parTime = maxTickMs = 0;
+            hits = playerHits = binned = overBudget = 0;
+        }
+        while(p.count < live) {
+            Vector2 pos = { player.x - 3000 + rand() % 6000, player.y - 3000 + rand() % 6000 };
+            float angle = (rand() % 6283)/1000.0f;
+            float speed = 100 + rand() % 400;
+            Vector2 vel = { cosf(angle)*speed, sinf(angle)*speed };
+            float life = 2 + rand() % 4;
+            projectiles_spawn(&p, pos, vel, life, 4);
+            projectiles_spawn(&par, pos, vel, life, 4);
+        }
+        // the player strafes so it gets hit from every side
+        player.x += sinf(t*0.02f)*4;
+
+        size_t expectedPlayer = 0, expected = 0;
+        bool check = t % 60 == 0;
+        if(check) expected = projectile_reference_hits(&p, level.items, level.count, player, dt, &expectedPlayer);
+
+        double start = bench_now();
+        projectiles_update(&p, &world, player, dt);
+        double tick = bench_now() - start;
+        time += tick;
+        if(tick*1000 > maxTickMs) maxTickMs = tick*1000;
+        overBudget += tick > dt;
+
+        start = bench_now();
+        projectiles_update_parallel(js, &par, &world, player, dt);
+        parTime += bench_now() - start;
+        if(par.count != p.count || par.hitCount != p.hitCount || memcmp(par.x, p.x, p.count*sizeof(float)) != 0) {
+            parMismatches++;
+        }
+
+        size_t tickPlayer = 0;
+        for(size_t i = 0; i < p.hitCount; i++) tickPlayer += p.hits[i].type == PROJECTILE_HIT_PLAYER;
+        hits += p.hitCount + p.droppedHits;
+        playerHits += tickPlayer;
+        binned += p.cellStart[PROJECTILE_GRID_CELLS];
+
+        if(check) {
+            checked++;
+            if(expected != p.hitCount + p.droppedHits || (p.droppedHits == 0 && expectedPlayer != tickPlayer)) mismatches++;
+        }
+    }
+
+    printf("{\"bench\":\"projectiles\",\"projectiles\":%zu,\"hz\":240,\"binned_per_tick\":%.0f,"
+           "\"hits_per_tick\":%.1f,\"player_hits\":%zu,\"ms_per_tick\":%.3f,\"max_ms\":%.3f,"
+           "\"budget_ms\":%.3f,\"over_budget_ticks\":%zu,\"checked_ticks\":%zu,\"mismatches\":%zu,\"threads\":%d,"
+           "\"parallel_ms_per_tick\":%.3f,\"parallel_mismatches\":%zu}\n",
+           live, (double)binned/ticks, (double)hits/ticks, playerHits, time*1000/ticks, maxTickMs, 1000.0/240,
+           overBudget, checked, mismatches, jobs_thread_count(js), parTime*1000/ticks, parMismatches);
+
+    jobs_destroy(js);
+    projectiles_free(&par);
+    projectiles_free(&p);
+    collision_world_free(&world);
+    da_free(&level);
+}
+
+// Builds the graph of a big level, replays every air link with player_step
+// in a world of the same colliders from a random point within a unit of its
+// start (each has to end standing on the span it leads to), then times agents
+// pathing to a target that moves, with and without the shared cache
+static void bench_nav(void) {
+    Colliders level = {0};
+    generate_level(&level, 1024, 31);
+
+    double start = bench_now();
+    NavGraph nav;
+    nav_build(&nav, level.items, level.count);
+    double buildMs = (bench_now() - start)*1000;
+
+    CollisionWorld world;
+    collision_world_build(&world, level.items, level.count);
+    size_t replayed = 0, mismatches = 0;
+    srand(30);
+    for(size_t i = 0; i < nav.linkCount; i++) {
+        const NavLink *link = &nav.links[i];
+        if(link->type == NAV_LINK_WALK) continue;
+
+        // the build stepped it from fromX and a unit to each side, an agent
+        // stops anywhere in between
+        Player p = nav_link_start(&nav, link);
+        p.pos.x += (rand() % 2001 - 1000)/1000.0f;
+        for(int t = 0; t < link->ticks; t++) player_step(&p, &world, nav_link_input(link, t), NAV_DT);
+        Vector2 feet = { p.pos.x + PLAYER_WIDTH/2.0f, p.pos.y + PLAYER_HEIGHT };
+        replayed++;
+        if(!p.isOnFloor || nav_locate(&nav, feet, 1) != link->to) mismatches++;
+    }
+
+    size_t agents = 10000, sampled = 500;
+    int frames = 60;
+    uint32_t *agentSpan = mem_alloc(MEM_TAG_SCRATCH, agents*sizeof(uint32_t));
+    float *agentX = mem_alloc(MEM_TAG_SCRATCH, agents*sizeof(float));
+    srand(32);
+    for(size_t a = 0; a < agents; a++) {
+        agentSpan[a] = (uint32_t)(rand() % nav.spanCount);
+        NavSpan span = nav.spans[agentSpan[a]];
+        agentX[a] = span.x0 + (span.x1 - span.x0)*(rand() % 1000)/1000.0f;
+    }
+
+    NavPathCache cache;
+    nav_cache_init(&cache, 1 << 14);
+    double cachedTime = 0, uncachedTime = 0;
+    size_t found = 0, uncachedFound = 0, totalLinks = 0;
+    uint32_t goal = 0;
+    for(int f = 0; f < frames; f++) {
+        // the target hops to another span every few frames
+        if(f % 10 == 0) goal = (uint32_t)(rand() % nav.spanCount);
+
+        start = bench_now();
+        for(size_t a = 0; a < agents; a++) {
+            const NavPath *path = nav_cache_find(&cache, &nav, agentSpan[a], agentX[a], goal);
+            if(path == NULL) continue;
+            found++;
+            totalLinks += path->count;
+        }
+        cachedTime += bench_now() - start;
+
+        NavPath path;
+        start = bench_now();
+        for(size_t a = 0; a < sampled; a++) {
+            uncachedFound += nav_find_path(&nav, agentSpan[a], agentX[a], goal, &path);
+        }
+        uncachedTime += bench_now() - start;
+    }
+
+    printf("{\"bench\":\"nav\",\"colliders\":%zu,\"build_ms\":%.1f,\"spans\":%zu,\"links\":%zu,"
+           "\"walk\":%zu,\"fall\":%zu,\"jump\":%zu,\"dash\":%zu,\"replayed\":%zu,\"mismatches\":%zu,"
+           "\"agents\":%zu,\"found_ratio\":%.3f,\"avg_links\":%.2f,\"uncached_us_per_path\":%.2f,"
+           "\"uncached_found_ratio\":%.3f,\"cached_ms_per_frame\":%.3f,\"hit_rate\":%.3f}\n",
+           level.count, buildMs, nav.spanCount, nav.linkCount, nav.linkCounts[NAV_LINK_WALK],
+           nav.linkCounts[NAV_LINK_FALL], nav.linkCounts[NAV_LINK_JUMP], nav.linkCounts[NAV_LINK_DASH], replayed,
+           mismatches, agents, (double)found/(agents*frames), found > 0 ? (double)totalLinks/found : 0,
+           uncachedTime*1e6/(sampled*frames), (double)uncachedFound/(sampled*frames), cachedTime*1000/frames,
+           (double)cache.hits/(cache.hits + cache.misses));
+
+    nav_cache_free(&cache);
+    mem_free(agentSpan);
+    mem_free(agentX);
+    collision_world_free(&world);
+    nav_free(&nav);
+    da_free(&level);
+
+    // the graph promises every link gets there when replayed near its start
+    if(mismatches != 0) {
+        fprintf(stderr, "nav: %zu links don't land on their span when replayed off their start\n", mismatches);
+        exit(1);
+    }
+}
+
+// Arcs of players thrown around a level against stepping them: how far the
+// closed form drifts from player_step_free and whether the first contact
+// lands on the tick player_step first gets pushed out of something
+static void bench_trajectory(void) {
+    Colliders level = {0};
+    generate_level(&level, 1024, 33);
+    CollisionWorld world;
+    collision_world_build(&world, level.items, level.count);
+
+    CollisionFilter filter = { COLLISION_LAYER_PLAYER, COLLISION_LAYER_SOLID };
+    int ticks = 60;
+    size_t samples = 20000;
+    Player *starts = mem_alloc(MEM_TAG_SCRATCH, samples*sizeof(Player));
+    PlayerInput *inputs = mem_alloc(MEM_TAG_SCRATCH, samples*sizeof(PlayerInput));
+    srand(34);
+    for(size_t i = 0; i < samples; i++) {
+        Player p;
+        Collider c;
+        // somewhere in the air, not inside anything
+        do {
+            const Collider *under = &level.items[rand() % level.count];
+            p = (Player){ .dir = 1 };
+            p.pos.x = under->x + (rand() % 1000)/1000.0f*under->width - PLAYER_WIDTH/2.0f;
+            p.pos.y = under->y - PLAYER_HEIGHT - 1 - rand() % 400;
+        } while(collision_query(&world, player_get_rec(&p), filter, &c, NULL, 1) > 0);
+
+        p.vel.x = (rand() % 2001) - 1000;
+        p.vel.y = (rand() % 3001) - 1500;
+        if(rand() % 3 == 0) {
+            p.jumping = true;
+            p.jumpTime = (rand() % 300)/1000.0f;
+            p.vel.y = -(rand() % 1500);
+        }
+        int hold = rand() % 3;
+        starts[i] = p;
+        inputs[i] = (PlayerInput){ .left = hold == 1, .right = hold == 2, .dashPressed = rand() % 4 == 0 };
+    }
+
+    // closed form against the stepped positions
+    double maxError = 0;
+    size_t totalPieces = 0;
+    PlayerArc arc;
+    for(size_t i = 0; i < samples; i++) {
+        player_arc(&starts[i], inputs[i], BENCH_DT, ticks, &arc);
+        totalPieces += arc.xCount + arc.yCount;
+
+        Player p = starts[i];
+        PlayerInput input = inputs[i];
+        for(int t = 1; t <= ticks; t++) {
+            player_step_free(&p, input, BENCH_DT);
+            input.dashPressed = false;
+            Vector2 at = player_arc_at(&arc, t);
+            maxError = fmax(maxError, fmax(fabsf(at.x - p.pos.x), fabsf(at.y - p.pos.y)));
+        }
+    }
+
+    // the first tick player_step ends somewhere else than the free step,
+    // 0 when it never does
+    int *steppedTick = mem_alloc(MEM_TAG_SCRATCH, samples*sizeof(int));
+    double start = bench_now();
+    for(size_t i = 0; i < samples; i++) {
+        Player p = starts[i], free = starts[i];
+        PlayerInput input = inputs[i];
+        steppedTick[i] = 0;
+        for(int t = 1; t <= ticks; t++) {
+            player_step(&p, &world, input, BENCH_DT);
+            player_step_free(&free, input, BENCH_DT);
+            input.dashPressed = false;
+            if(p.pos.x != free.pos.x || p.pos.y != free.pos.y || p.isOnFloor) {
+                steppedTick[i] = t;
+                break;
+            }
+        }
+    }
+    double steppedTime = bench_now() - start;
+
+    size_t hits = 0, agree = 0;
+    start = bench_now();
+    for(size_t i = 0; i < samples; i++) {
+        PlayerArcHit hit;
+        player_arc(&starts[i], inputs[i], BENCH_DT, ticks, &arc);
+        int tick = player_arc_hit(&arc, &world, &hit) ? hit.tick : 0;
+        hits += tick > 0;
+        agree += tick == steppedTick[i];
+    }
+    double arcTime = bench_now() - start;
+
+    printf("{\"bench\":\"trajectory\",\"samples\":%zu,\"ticks\":%d,\"avg_pieces\":%.2f,\"max_error\":%.6f,"
+           "\"hits\":%zu,\"hit_tick_agreement\":%.4f,\"stepped_us\":%.3f,\"arc_us\":%.3f}\n",
+           samples, ticks, (double)totalPieces/samples, maxError, hits, (double)agree/samples,
+           steppedTime*1e6/samples, arcTime*1e6/samples);
+
+    mem_free(steppedTick);
+    mem_free(starts);
+    mem_free(inputs);
+    collision_world_free(&world);
+    da_free(&level);
+}
+
+// Runs after the others: what each tag holds once they freed everything
+// (anything left is a leak) and the peaks they reached
+static void bench_memory(void) {
+    // a budget has to refuse what goes over it and nothing else
+    mem_set_budget(MEM_TAG_RENDER, 1 << 20);
+    void *fits = mem_alloc(MEM_TAG_RENDER, 1 << 19);
+    void *over = mem_alloc(MEM_TAG_RENDER, 1 << 20);
+    bool enforced = fits != NULL && over == NULL;
+    mem_free(fits);
+    mem_free(over);
+
+    // the particles go without lanes instead of aborting
+    ParticleSystem ps;
+    particles_init(&ps, 1 << 20, 0, 0);
+    ParticleEmitter emitter = { .life = 1, .size = 1 };
+    particles_emit(&ps, &emitter, (Vector2){ 0, 0 }, 10);
+    particles_update(&ps, BENCH_DT);
+    bool particlesDegrade = ps.capacity == 0 && ps.count == 0 && ps.dropped == 10;
+    particles_free(&ps);
+    mem_set_budget(MEM_TAG_RENDER, 0);
+
+    // the projectiles make do with the lanes the budget leaves them
+    MemStats physics = mem_stats(MEM_TAG_PHYSICS);
+    mem_set_budget(MEM_TAG_PHYSICS, physics.live + (1 << 20));
+    Projectiles projectiles;
+    projectiles_init(&projectiles, 1 << 20);
+    size_t lanes = projectiles.capacity;
+    for(size_t i = 0; i < lanes + 10; i++) projectiles_spawn(&projectiles, (Vector2){ 0, 0 }, (Vector2){ 1, 0 }, 1, 1);
+    projectiles_update(&projectiles, &(CollisionWorld){0}, (Rectangle){ 0, 0, 1, 1 }, BENCH_DT);
+    bool projectilesDegrade = lanes > 0 && lanes < (1 << 20) && projectiles.dropped == 10;
+    projectiles_free(&projectiles);
+    mem_set_budget(MEM_TAG_PHYSICS, 0);
+
+    // a stream with no room for its queue loads nothing and keeps going
+    ChunkStream stream;
+    StreamConfig config = { .chunkSize = 256, .loadRadius = 2, .evictRadius = 4, .loadsPerTick = 4 };
+    stream_init(&stream, config, 64, 64, (Vector2){ 0, 0 }, NULL, NULL, NULL);
+    MemStats streaming = mem_stats(MEM_TAG_STREAMING);
+    mem_set_budget(MEM_TAG_STREAMING, streaming.live);
+    Player player = { .pos = { 4000, 4000 }, .dir = PLAYER_DIR_RIGHT, .riding = COLLIDER_REF_NONE };
+    for(int t = 0; t < 10; t++) stream_update(&stream, &player, (PlayerInput){0}, BENCH_DT);
+    bool streamDegrades = stream.loads == 0;
+    mem_set_budget(MEM_TAG_STREAMING, 0);
+    for(int t = 0; t < 10; t++) stream_update(&stream, &player, (PlayerInput){0}, BENCH_DT);
+    streamDegrades = streamDegrades && stream.loads > 0;
+    stream_free(&stream);
+
+    printf("{\"bench\":\"memory\",\"budget_enforced\":%s,\"particles_degrade\":%s,\"projectiles_degrade\":%s,"
+           "\"stream_degrades\":%s,\"tags\":{",
+           enforced ? "true" : "false", particlesDegrade ? "true" : "false", projectilesDegrade ? "true" : "false",
+           streamDegrades ? "true" : "false");
+    for(int t = 0; t < MEM_TAG_COUNT; t++) {
+        MemStats stats = mem_stats(t);
+        printf("%s\"%s\":{\"live\":%zu,\"peak\":%zu,\"allocations\":%zu,\"failures\":%zu}",
+               t == 0 ? "" : ",", mem_tag_name(t), stats.live, stats.peak, stats.allocations, stats.failures);
+    }
+    printf("}}\n");
+}
+
+static bool should_run(int argc, char **argv, const char *name) {
+    if(argc < 2) return true;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], name) == 0) return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    int maxThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if(maxThreads < 4) maxThreads = 4;
+    if(maxThreads > JOBS_MAX_THREADS) maxThreads = JOBS_MAX_THREADS;
+
+    if(should_run(argc, argv, "jobs_scaling")) bench_jobs_scaling(maxThreads);
+    if(should_run(argc, argv, "env_steps")) bench_env_steps(maxThreads);
+    if(should_run(argc, argv, "static_index")) bench_static_index();
+    if(should_run(argc, argv, "static_order")) bench_static_order();
+    if(should_run(argc, argv, "compact")) bench_compact();
+    if(should_run(argc, argv, "origin")) bench_origin();
+    if(should_run(argc, argv, "stream")) bench_stream();
+    if(should_run(argc, argv, "level_cache")) bench_level_cache();
+    if(should_run(argc, argv, "pool")) bench_pool();
+    if(should_run(argc, argv, "raycast")) bench_raycast(maxThreads);
+    if(should_run(argc, argv, "moving_platforms")) bench_moving_platforms();
+    if(should_run(argc, argv, "sap")) bench_sap();
+    if(should_run(argc, argv, "particles")) bench_particles(maxThreads);
+    if(should_run(argc, argv, "projectiles")) bench_projectiles(maxThreads);
+    if(should_run(argc, argv, "nav")) bench_nav();
+    if(should_run(argc, argv, "trajectory")) bench_trajectory();
+    if(should_run(argc, argv, "memory")) bench_memory();
+
+    return 0;
+}
@@ -0,0 +1,237 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+#include "level.h"
+#include "utils.h"
+
+#define LEVEL_CACHE_MAGIC "LVLCACHE"
+#define LEVEL_CACHE_DATA_ALIGN 64
+#define LEVEL_CACHE_MAX_PATH 1024
+
+// Where the arrays are, as offsets from the start of the file
+typedef struct {
+    float cellSize;
+    int32_t cols;
+    int32_t rows;
+    uint32_t pad;
+    uint64_t cellStart;
+    uint64_t cellItems;
+} CacheGrid;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t levelCount;
+    uint64_t hash;
+    uint64_t count;
+    uint64_t fileSize;
+    float originX;
+    float originY;
+    uint64_t minX;
+    uint64_t minY;
+    uint64_t maxX;
+    uint64_t maxY;
+    uint64_t category;
+    uint64_t mask;
+    uint64_t source;
+    uint64_t position;
+    CacheGrid levels[STATIC_INDEX_MAX_LEVELS];
+} CacheHeader;
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static uint64_t level_hash(const Rectangle *rects, size_t count) {
+    uint32_t version = LEVEL_CACHE_VERSION;
+    uint64_t n = count;
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash = fnv1a(hash, &version, sizeof(version));
+    hash = fnv1a(hash, &n, sizeof(n));
+    return fnv1a(hash, rects, count*sizeof(Rectangle));
+}
+
+static size_t data_offset(void) {
+    return (sizeof(CacheHeader) + LEVEL_CACHE_DATA_ALIGN - 1)/LEVEL_CACHE_DATA_ALIGN*LEVEL_CACHE_DATA_ALIGN;
+}
+
+// Whether count elements of size at offset are inside the data of the file
+// and aligned for them
+static bool fits(uint64_t offset, uint64_t count, size_t size, size_t fileSize) {
+    return offset >= data_offset() && offset % size == 0 && offset <= fileSize &&
+           count <= (fileSize - offset)/size;
+}
+
+static bool below(const char *map, uint64_t offset, uint64_t count, uint64_t limit) {
+    const uint32_t *values = (const uint32_t*)(map + offset);
+    for(uint64_t i = 0; i < count; i++) {
+        if(values[i] >= limit) return false;
+    }
+    return true;
+}
+
+// The hash only covers the input, a file that is cut or corrupted past the
+// header must not send a query out of the mapping
+static bool valid_arrays(const CacheHeader *h, const char *map, size_t size) {
+    uint64_t count = h->count;
+    if(count > UINT32_MAX) return false;
+
+    uint64_t arrays[] = { h->minX, h->minY, h->maxX, h->maxY, h->category, h->mask, h->source, h->position };
+    for(size_t i = 0; i < sizeof(arrays)/sizeof(arrays[0]); i++) {
+        if(!fits(arrays[i], count, sizeof(uint32_t), size)) return false;
+    }
+    if(!below(map, h->source, count, count) || !below(map, h->position, count, count)) return false;
+
+    for(uint32_t l = 0; l < h->levelCount; l++) {
+        const CacheGrid *g = &h->levels[l];
+        if(!(g->cellSize > 0) || g->cols <= 0 || g->rows <= 0) return false;
+
+        uint64_t cells = (uint64_t)g->cols*(uint64_t)g->rows;
+        if(!fits(g->cellStart, cells + 1, sizeof(uint32_t), size)) return false;
+
+        // each cell starts where the previous one ends, the last start is
+        // the length of the items
+        const uint32_t *start = (const uint32_t*)(map + g->cellStart);
+        if(start[0] != 0) return false;
+        for(uint64_t c = 0; c < cells; c++) {
+            if(start[c + 1] < start[c]) return false;
+        }
+        if(!fits(g->cellItems, start[cells], sizeof(uint32_t), size)) return false;
+        if(!below(map, g->cellItems, start[cells], count)) return false;
+    }
+    return true;
+}
+
+static bool map_index(StaticIndex *index, const char *path, uint64_t hash) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < data_offset()) {
+        close(fd);
+        return false;
+    }
+
+    // private and writable, a rebase copies the pages it shifts
+    size_t size = st.st_size;
+    char *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) return false;
+
+    const CacheHeader *h = (const CacheHeader*)map;
+    if(memcmp(h->magic, LEVEL_CACHE_MAGIC, 8) != 0 || h->version != LEVEL_CACHE_VERSION ||
+       h->hash != hash || h->fileSize != size || h->levelCount > STATIC_INDEX_MAX_LEVELS ||
+       !valid_arrays(h, map, size)) {
+        munmap(map, size);
+        return false;
+    }
+
+    *index = (StaticIndex) {
+        .minX = (const float*)(map + h->minX),
+        .minY = (const float*)(map + h->minY),
+        .maxX = (const float*)(map + h->maxX),
+        .maxY = (const float*)(map + h->maxY),
+        .category = (const uint32_t*)(map + h->category),
+        .mask = (const uint32_t*)(map + h->mask),
+        .count = h->count,
+        .source = (const uint32_t*)(map + h->source),
+        .position = (const uint32_t*)(map + h->position),
+        .originX = h->originX,
+        .originY = h->originY,
+        .levelCount = h->levelCount,
+        .memory = map,
+        .memorySize = size - data_offset(),
+        .mappedSize = size,
+    };
+    for(uint32_t l = 0; l < h->levelCount; l++) {
+        index->levels[l] = (StaticGrid) {
+            .cellSize = h->levels[l].cellSize,
+            .cols = h->levels[l].cols,
+            .rows = h->levels[l].rows,
+            .cellStart = (const uint32_t*)(map + h->levels[l].cellStart),
+            .cellItems = (const uint32_t*)(map + h->levels[l].cellItems),
+        };
+    }
+
+    return true;
+}
+
+static uint64_t offset_of(const StaticIndex *index, const void *ptr) {
+    return data_offset() + (uint64_t)((const char*)ptr - (const char*)index->memory);
+}
+
+// Written next to the final name and renamed, a crash never leaves half a file
+static void write_index(const StaticIndex *index, const char *dir, const char *path, uint64_t hash) {
+    CacheHeader h = {
+        .version = LEVEL_CACHE_VERSION,
+        .levelCount = index->levelCount,
+        .hash = hash,
+        .count = index->count,
+        .fileSize = data_offset() + index->memorySize,
+        .originX = index->originX,
+        .originY = index->originY,
+        .minX = offset_of(index, index->minX),
+        .minY = offset_of(index, index->minY),
+        .maxX = offset_of(index, index->maxX),
+        .maxY = offset_of(index, index->maxY),
+        .category = offset_of(index, index->category),
+        .mask = offset_of(index, index->mask),
+        .source = offset_of(index, index->source),
+        .position = offset_of(index, index->position),
+    };
+    memcpy(h.magic, LEVEL_CACHE_MAGIC, 8);
+    for(int l = 0; l < index->levelCount; l++) {
+        h.levels[l] = (CacheGrid) {
+            .cellSize = index->levels[l].cellSize,
+            .cols = index->levels[l].cols,
+            .rows = index->levels[l].rows,
+            .cellStart = offset_of(index, index->levels[l].cellStart),
+            .cellItems = offset_of(index, index->levels[l].cellItems),
+        };
+    }
+
+    if(mkdir(dir, 0755) != 0 && errno != EEXIST) return;
+
+    char tmp[LEVEL_CACHE_MAX_PATH + 32];
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+    FILE *f = fopen(tmp, "wb");
+    if(f == NULL) return;
+
+    char pad[LEVEL_CACHE_DATA_ALIGN] = {0};
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+              fwrite(pad, data_offset() - sizeof(h), 1, f) == 1 &&
+              fwrite(index->memory, index->memorySize, 1, f) == 1;
+    ok = fclose(f) == 0 && ok;
+
+    if(!ok || rename(tmp, path) != 0) remove(tmp);
+}
+
+bool level_cache_load(StaticIndex *index, const char *dir, const Rectangle *rects, size_t count) {
+    uint64_t hash = level_hash(rects, count);
+    char path[LEVEL_CACHE_MAX_PATH];
+    int length = snprintf(path, sizeof(path), "%s/%016llx.lvc", dir, (unsigned long long)hash);
+    bool usable = length > 0 && length < (int)sizeof(path);
+
+    if(usable && map_index(index, path, hash)) return true;
+
+    Colliders colliders = {0};
+    level_merge_rects(&colliders, rects, count);
+    static_index_build(index, colliders.items, colliders.count);
+    da_free(&colliders);
+
+    // a cache that can't be written only costs the next launch a rebuild
+    if(usable) write_index(index, dir, path, hash);
+    return false;
+}
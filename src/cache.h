@@ -0,0 +1,18 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdbool.h>
+#include "raylib.h"
+#include "collision.h"
+
+// Bump it whenever the merge or the index change, older files are ignored
+#define LEVEL_CACHE_VERSION 2
+
+// Fills index with the merged and indexed platforms of a level. When a
+// previous run already built them they are mapped from dir, otherwise they
+// are built and written there for the next one. The file is named after the
+// hash of the platforms and the version, so an edited level gets a new one.
+// Returns true when it came from the cache.
+bool level_cache_load(StaticIndex *index, const char *dir, const Rectangle *rects, size_t count);
+
+#endif // CACHE_H
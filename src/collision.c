@@ -0,0 +1,722 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/mman.h>
+
+#include "collision.h"
+#include "tilemap.h"
+#include "utils.h"
+#include "mem.h"
+
+#define STATIC_INDEX_MIN_CELL_SIZE 64
+#define STATIC_INDEX_MAX_CELLS_PER_ITEM 4
+
+static bool overlaps(float minX, float minY, float maxX, float maxY, Rectangle area) {
+    return minX < area.x + area.width && maxX > area.x &&
+           minY < area.y + area.height && maxY > area.y;
+}
+
+static int cell_coord(float value, float origin, float cellSize, int cells) {
+    int c = (int)floorf((value - origin)/cellSize);
+    if(c < 0) return 0;
+    if(c >= cells) return cells - 1;
+    return c;
+}
+
+static void cell_range(const StaticGrid *grid, float originX, float originY,
+                       float minX, float minY, float maxX, float maxY, int *x0, int *y0, int *x1, int *y1) {
+    *x0 = cell_coord(minX, originX, grid->cellSize, grid->cols);
+    *x1 = cell_coord(maxX, originX, grid->cellSize, grid->cols);
+    *y0 = cell_coord(minY, originY, grid->cellSize, grid->rows);
+    *y1 = cell_coord(maxY, originY, grid->cellSize, grid->rows);
+}
+
+// The first level whose cells are at least as big as the collider
+static int size_level(Collider c) {
+    float size = fmaxf(c.width, c.height);
+    float cellSize = STATIC_INDEX_MIN_CELL_SIZE;
+    int level = 0;
+    while(cellSize < size && level < STATIC_INDEX_MAX_LEVELS - 1) {
+        cellSize *= 2;
+        level++;
+    }
+    return level;
+}
+
+// The low 16 bits of v on the even bits
+static uint32_t spread_bits(uint32_t v) {
+    v &= 0xffff;
+    v = (v | v << 8) & 0x00ff00ffu;
+    v = (v | v << 4) & 0x0f0f0f0fu;
+    v = (v | v << 2) & 0x33333333u;
+    v = (v | v << 1) & 0x55555555u;
+    return v;
+}
+
+static int compare_keys(const void *a, const void *b) {
+    uint64_t ka = *(const uint64_t*)a, kb = *(const uint64_t*)b;
+    return (ka > kb) - (ka < kb);
+}
+
+static void build(StaticIndex *index, const Collider *input, size_t count, bool spatialOrder) {
+    *index = (StaticIndex){0};
+
+    float minX = 0, minY = 0, maxX = 0, maxY = 0;
+    for(size_t i = 0; i < count; i++) {
+        Collider c = input[i];
+        if(i == 0 || c.x < minX) minX = c.x;
+        if(i == 0 || c.y < minY) minY = c.y;
+        if(i == 0 || c.x + c.width > maxX) maxX = c.x + c.width;
+        if(i == 0 || c.y + c.height > maxY) maxY = c.y + c.height;
+    }
+
+    // the Morton code of the center on a 65536x65536 grid over the bounds,
+    // the input index in the low bits keeps the sort stable
+    uint64_t *keys = mem_alloc(MEM_TAG_SCRATCH, (count + 1)*sizeof(uint64_t));
+    Collider *colliders = mem_alloc(MEM_TAG_SCRATCH, (count + 1)*sizeof(Collider));
+    assert(keys != NULL && colliders != NULL && "No enough ram");
+
+    float scaleX = maxX > minX ? 65535/(maxX - minX) : 0;
+    float scaleY = maxY > minY ? 65535/(maxY - minY) : 0;
+    for(size_t i = 0; i < count; i++) {
+        uint32_t morton = 0;
+        if(spatialOrder) {
+            Collider c = input[i];
+            uint32_t qx = (uint32_t)((c.x + c.width*0.5f - minX)*scaleX);
+            uint32_t qy = (uint32_t)((c.y + c.height*0.5f - minY)*scaleY);
+            morton = spread_bits(qx) | spread_bits(qy) << 1;
+        }
+        keys[i] = (uint64_t)morton << 32 | i;
+    }
+    if(spatialOrder) qsort(keys, count, sizeof(uint64_t), compare_keys);
+    for(size_t i = 0; i < count; i++) colliders[i] = input[(uint32_t)keys[i]];
+
+    uint8_t *itemGrid = mem_alloc(MEM_TAG_SCRATCH, count + 1);
+    assert(itemGrid != NULL && "No enough ram");
+
+    size_t levelItems[STATIC_INDEX_MAX_LEVELS] = {0};
+    for(size_t i = 0; i < count; i++) {
+        itemGrid[i] = size_level(colliders[i]);
+        levelItems[itemGrid[i]]++;
+    }
+
+    // only the levels with colliders get a grid. A level sparse enough to be
+    // mostly empty cells gets bigger ones, so memory stays linear in count.
+    StaticGrid grids[STATIC_INDEX_MAX_LEVELS];
+    size_t gridItems[STATIC_INDEX_MAX_LEVELS];
+    int gridOf[STATIC_INDEX_MAX_LEVELS] = {0};
+    int gridCount = 0;
+    for(int l = 0; l < STATIC_INDEX_MAX_LEVELS; l++) {
+        if(levelItems[l] == 0) continue;
+
+        float cellSize = ldexpf(STATIC_INDEX_MIN_CELL_SIZE, l);
+        int cols, rows;
+        for(;;) {
+            cols = (int)ceilf((maxX - minX)/cellSize);
+            rows = (int)ceilf((maxY - minY)/cellSize);
+            if(cols < 1) cols = 1;
+            if(rows < 1) rows = 1;
+            if((size_t)cols*rows <= STATIC_INDEX_MAX_CELLS_PER_ITEM*levelItems[l] + 1) break;
+            cellSize *= 2;
+        }
+
+        gridOf[l] = gridCount;
+        gridItems[gridCount] = 0;
+        grids[gridCount++] = (StaticGrid) {
+            .cellSize = cellSize,
+            .cols = cols,
+            .rows = rows,
+        };
+    }
+    for(size_t i = 0; i < count; i++) itemGrid[i] = gridOf[itemGrid[i]];
+
+    size_t cellTotal = 0, refTotal = 0;
+    for(size_t i = 0; i < count; i++) {
+        Collider c = colliders[i];
+        int x0, y0, x1, y1;
+        cell_range(&grids[itemGrid[i]], minX, minY, c.x, c.y, c.x + c.width, c.y + c.height, &x0, &y0, &x1, &y1);
+        size_t refs = (size_t)(x1 - x0 + 1)*(y1 - y0 + 1);
+        gridItems[itemGrid[i]] += refs;
+        refTotal += refs;
+    }
+    for(int g = 0; g < gridCount; g++) cellTotal += (size_t)grids[g].cols*grids[g].rows + 1;
+
+    size_t size = 4*count*sizeof(float) + (4*count + cellTotal + refTotal)*sizeof(uint32_t);
+    char *memory = mem_alloc(MEM_TAG_LEVEL, size > 0 ? size : 1);
+    assert(memory != NULL && "No enough ram");
+
+    float *bMinX = (float*)memory;
+    float *bMinY = bMinX + count;
+    float *bMaxX = bMinY + count;
+    float *bMaxY = bMaxX + count;
+    uint32_t *category = (uint32_t*)(bMaxY + count);
+    uint32_t *mask = category + count;
+    uint32_t *source = mask + count;
+    uint32_t *position = source + count;
+    for(size_t i = 0; i < count; i++) {
+        source[i] = (uint32_t)keys[i];
+        position[source[i]] = i;
+    }
+    mem_free(keys);
+
+    // the offsets of every level first, then their items
+    uint32_t *cellStart[STATIC_INDEX_MAX_LEVELS];
+    uint32_t *cellItems[STATIC_INDEX_MAX_LEVELS];
+    uint32_t *cursor = position + count;
+    for(int g = 0; g < gridCount; g++) {
+        size_t cells = (size_t)grids[g].cols*grids[g].rows;
+        cellStart[g] = cursor;
+        for(size_t c = 0; c <= cells; c++) cellStart[g][c] = 0;
+        cursor += cells + 1;
+    }
+    for(int g = 0; g < gridCount; g++) {
+        cellItems[g] = cursor;
+        cursor += gridItems[g];
+    }
+
+    for(size_t i = 0; i < count; i++) {
+        Collider c = colliders[i];
+        bMinX[i] = c.x;
+        bMinY[i] = c.y;
+        bMaxX[i] = c.x + c.width;
+        bMaxY[i] = c.y + c.height;
+        category[i] = c.category;
+        mask[i] = c.mask;
+
+        int g = itemGrid[i], x0, y0, x1, y1;
+        cell_range(&grids[g], minX, minY, bMinX[i], bMinY[i], bMaxX[i], bMaxY[i], &x0, &y0, &x1, &y1);
+        for(int y = y0; y <= y1; y++) {
+            for(int x = x0; x <= x1; x++) cellStart[g][y*grids[g].cols + x + 1]++;
+        }
+    }
+
+    for(int g = 0; g < gridCount; g++) {
+        size_t cells = (size_t)grids[g].cols*grids[g].rows;
+        for(size_t c = 0; c < cells; c++) cellStart[g][c + 1] += cellStart[g][c];
+    }
+
+    // cellStart[c] is used as the write cursor of c and shifted back after
+    for(size_t i = 0; i < count; i++) {
+        int g = itemGrid[i], x0, y0, x1, y1;
+        cell_range(&grids[g], minX, minY, bMinX[i], bMinY[i], bMaxX[i], bMaxY[i], &x0, &y0, &x1, &y1);
+        for(int y = y0; y <= y1; y++) {
+            for(int x = x0; x <= x1; x++) cellItems[g][cellStart[g][y*grids[g].cols + x]++] = i;
+        }
+    }
+    for(int g = 0; g < gridCount; g++) {
+        size_t cells = (size_t)grids[g].cols*grids[g].rows;
+        for(size_t c = cells; c > 0; c--) cellStart[g][c] = cellStart[g][c - 1];
+        cellStart[g][0] = 0;
+
+        grids[g].cellStart = cellStart[g];
+        grids[g].cellItems = cellItems[g];
+    }
+    mem_free(itemGrid);
+    mem_free(colliders);
+
+    *index = (StaticIndex) {
+        .minX = bMinX,
+        .minY = bMinY,
+        .maxX = bMaxX,
+        .maxY = bMaxY,
+        .category = category,
+        .mask = mask,
+        .count = count,
+        .source = source,
+        .position = position,
+        .originX = minX,
+        .originY = minY,
+        .levelCount = gridCount,
+        .memory = memory,
+        .memorySize = size,
+    };
+    for(int g = 0; g < gridCount; g++) index->levels[g] = grids[g];
+}
+
+void static_index_build(StaticIndex *index, const Collider *colliders, size_t count) {
+    build(index, colliders, count, true);
+}
+
+void static_index_build_in_order(StaticIndex *index, const Collider *colliders, size_t count) {
+    build(index, colliders, count, false);
+}
+
+// An index without memory points to tables compiled in, read only. Copies
+// them to the heap the first time something has to write to them.
+static void static_index_own(StaticIndex *index) {
+    if(index->memory != NULL || index->count == 0) return;
+
+    size_t count = index->count;
+    size_t words = 8*count;
+    for(int l = 0; l < index->levelCount; l++) {
+        const StaticGrid *grid = &index->levels[l];
+        size_t cells = (size_t)grid->cols*grid->rows;
+        words += cells + 1 + grid->cellStart[cells];
+    }
+
+    char *memory = mem_alloc(MEM_TAG_LEVEL, words*sizeof(uint32_t));
+    assert(memory != NULL && "No enough ram");
+
+    float *floats = (float*)memory;
+    memcpy(floats, index->minX, count*sizeof(float));
+    memcpy(floats + count, index->minY, count*sizeof(float));
+    memcpy(floats + 2*count, index->maxX, count*sizeof(float));
+    memcpy(floats + 3*count, index->maxY, count*sizeof(float));
+    index->minX = floats;
+    index->minY = floats + count;
+    index->maxX = floats + 2*count;
+    index->maxY = floats + 3*count;
+
+    uint32_t *cursor = (uint32_t*)(floats + 4*count);
+    const uint32_t **arrays[] = { &index->category, &index->mask, &index->source, &index->position };
+    for(size_t a = 0; a < 4; a++) {
+        memcpy(cursor, *arrays[a], count*sizeof(uint32_t));
+        *arrays[a] = cursor;
+        cursor += count;
+    }
+
+    for(int l = 0; l < index->levelCount; l++) {
+        StaticGrid *grid = &index->levels[l];
+        size_t cells = (size_t)grid->cols*grid->rows;
+        size_t items = grid->cellStart[cells];
+        memcpy(cursor, grid->cellStart, (cells + 1)*sizeof(uint32_t));
+        memcpy(cursor + cells + 1, grid->cellItems, items*sizeof(uint32_t));
+        grid->cellStart = cursor;
+        grid->cellItems = cursor + cells + 1;
+        cursor += cells + 1 + items;
+    }
+
+    index->memory = memory;
+    index->memorySize = words*sizeof(uint32_t);
+}
+
+void static_index_shift(StaticIndex *index, Vector2 delta) {
+    static_index_own(index);
+
+    // the arrays are owned by the index, only the view is read only
+    float *minX = (float*)index->minX, *minY = (float*)index->minY;
+    float *maxX = (float*)index->maxX, *maxY = (float*)index->maxY;
+    for(size_t i = 0; i < index->count; i++) {
+        minX[i] += delta.x;
+        maxX[i] += delta.x;
+    }
+    for(size_t i = 0; i < index->count; i++) {
+        minY[i] += delta.y;
+        maxY[i] += delta.y;
+    }
+
+    // the cells are relative to the origin and don't change
+    index->originX += delta.x;
+    index->originY += delta.y;
+}
+
+void static_index_free(StaticIndex *index) {
+    if(index->mappedSize > 0) munmap(index->memory, index->mappedSize);
+    else mem_free(index->memory);
+    *index = (StaticIndex){0};
+}
+
+Collider static_index_get(const StaticIndex *index, uint32_t i) {
+    return (Collider) {
+        .x = index->minX[i],
+        .y = index->minY[i],
+        .width = index->maxX[i] - index->minX[i],
+        .height = index->maxY[i] - index->minY[i],
+        .category = index->category[i],
+        .mask = index->mask[i],
+    };
+}
+
+// Shared by the public queries, any of the outputs can be NULL. The levels
+// are walked from the coarsest down, each collider is in only one of them.
+static size_t static_query(const StaticIndex *index, Rectangle area, CollisionFilter filter,
+                           uint32_t *outIndices, Collider *outColliders, size_t max) {
+    size_t found = 0;
+
+    for(int l = index->levelCount - 1; l >= 0; l--) {
+        const StaticGrid *grid = &index->levels[l];
+        int x0, y0, x1, y1;
+        cell_range(grid, index->originX, index->originY, area.x, area.y, area.x + area.width, area.y + area.height,
+                   &x0, &y0, &x1, &y1);
+
+        for(int y = y0; y <= y1; y++) {
+            for(int x = x0; x <= x1; x++) {
+                size_t c = (size_t)y*grid->cols + x;
+
+                for(uint32_t k = grid->cellStart[c]; k < grid->cellStart[c + 1]; k++) {
+                    uint32_t i = grid->cellItems[k];
+                    if(!collision_filter_accepts(filter, index->category[i], index->mask[i])) continue;
+                    if(!overlaps(index->minX[i], index->minY[i], index->maxX[i], index->maxY[i], area)) {
+                        continue;
+                    }
+
+                    // a collider spanning several cells is only reported by
+                    // the cell holding the top left corner of its overlap
+                    float refX = fmaxf(index->minX[i], area.x);
+                    float refY = fmaxf(index->minY[i], area.y);
+                    if(cell_coord(refX, index->originX, grid->cellSize, grid->cols) != x ||
+                       cell_coord(refY, index->originY, grid->cellSize, grid->rows) != y) {
+                        continue;
+                    }
+
+                    if(found == max) return found;
+                    if(outIndices != NULL) outIndices[found] = i;
+                    if(outColliders != NULL) outColliders[found] = static_index_get(index, i);
+                    found++;
+                }
+            }
+        }
+    }
+
+    return found;
+}
+
+size_t static_index_query(const StaticIndex *index, Rectangle area, CollisionFilter filter, uint32_t *out, size_t max) {
+    return static_query(index, area, filter, out, NULL, max);
+}
+
+size_t static_index_query_colliders(const StaticIndex *index, Rectangle area, CollisionFilter filter,
+                                    Collider *out, size_t max) {
+    return static_query(index, area, filter, NULL, out, max);
+}
+
+// offset counts the cells the world was shifted by since the items were
+// binned, so a shift doesn't move anything in the hash
+static int dynamic_cell(float value, int offset) {
+    return (int)floorf(value/DYNAMIC_INDEX_CELL_SIZE) - offset;
+}
+
+static Rectangle fat_box(Collider c) {
+    return (Rectangle) {
+        .x = c.x - DYNAMIC_INDEX_FAT_MARGIN,
+        .y = c.y - DYNAMIC_INDEX_FAT_MARGIN,
+        .width = c.width + 2*DYNAMIC_INDEX_FAT_MARGIN,
+        .height = c.height + 2*DYNAMIC_INDEX_FAT_MARGIN,
+    };
+}
+
+static bool contains(Rectangle outer, Collider c) {
+    return c.x >= outer.x && c.y >= outer.y &&
+           c.x + c.width <= outer.x + outer.width &&
+           c.y + c.height <= outer.y + outer.height;
+}
+
+static void *grow(void *ptr, size_t count, size_t size) {
+    ptr = mem_realloc(MEM_TAG_PHYSICS, ptr, count*size);
+    assert(ptr != NULL && "No enough ram");
+    return ptr;
+}
+
+static void dynamic_bin(DynamicIndex *dyn, uint32_t item) {
+    Rectangle fat = dyn->fat[item];
+    int x0 = dynamic_cell(fat.x, dyn->cellOffsetX), x1 = dynamic_cell(fat.x + fat.width, dyn->cellOffsetX);
+    int y0 = dynamic_cell(fat.y, dyn->cellOffsetY), y1 = dynamic_cell(fat.y + fat.height, dyn->cellOffsetY);
+
+    for(int cy = y0; cy <= y1; cy++) {
+        for(int cx = x0; cx <= x1; cx++) {
+            uint32_t node = dyn->freeNode;
+            if(node != DYNAMIC_INDEX_NODE_NONE) {
+                dyn->freeNode = dyn->nodes[node].next;
+            } else {
+                if(dyn->nodeCount == dyn->nodeCapacity) {
+                    dyn->nodeCapacity = dyn->nodeCapacity == 0 ? DA_INIT_CAP : dyn->nodeCapacity*2;
+                    dyn->nodes = grow(dyn->nodes, dyn->nodeCapacity, sizeof(DynamicNode));
+                }
+                node = dyn->nodeCount++;
+            }
+
+            uint32_t b = dynamic_index_bucket(cx, cy);
+            dyn->nodes[node] = (DynamicNode) {
+                .item = item,
+                .cx = cx,
+                .cy = cy,
+                .next = dyn->buckets[b],
+            };
+            dyn->buckets[b] = node;
+        }
+    }
+}
+
+static void dynamic_unbin(DynamicIndex *dyn, uint32_t item) {
+    Rectangle fat = dyn->fat[item];
+    int x0 = dynamic_cell(fat.x, dyn->cellOffsetX), x1 = dynamic_cell(fat.x + fat.width, dyn->cellOffsetX);
+    int y0 = dynamic_cell(fat.y, dyn->cellOffsetY), y1 = dynamic_cell(fat.y + fat.height, dyn->cellOffsetY);
+
+    for(int cy = y0; cy <= y1; cy++) {
+        for(int cx = x0; cx <= x1; cx++) {
+            uint32_t *link = &dyn->buckets[dynamic_index_bucket(cx, cy)];
+            while(*link != DYNAMIC_INDEX_NODE_NONE) {
+                DynamicNode *n = &dyn->nodes[*link];
+                if(n->item == item && n->cx == cx && n->cy == cy) {
+                    uint32_t node = *link;
+                    *link = n->next;
+                    n->next = dyn->freeNode;
+                    dyn->freeNode = node;
+                    break;
+                }
+                link = &n->next;
+            }
+        }
+    }
+}
+
+// Same contract as static_query, colliders spanning several cells are
+// reported by the cell of the top left corner of their fat box overlap
+static size_t dynamic_query(const DynamicIndex *dyn, Rectangle area, CollisionFilter filter,
+                            Collider *out, ColliderRef *refs, size_t max) {
+    if(dyn->count == 0 || max == 0) return 0;
+
+    int x0 = dynamic_cell(area.x, dyn->cellOffsetX), x1 = dynamic_cell(area.x + area.width, dyn->cellOffsetX);
+    int y0 = dynamic_cell(area.y, dyn->cellOffsetY), y1 = dynamic_cell(area.y + area.height, dyn->cellOffsetY);
+    size_t found = 0;
+
+    // an area covering more cells than there are colliders is cheaper to scan
+    if((size_t)(x1 - x0 + 1)*(y1 - y0 + 1) > dyn->count) {
+        for(size_t i = 0; i < dyn->count && found < max; i++) {
+            Collider c = dyn->items[i];
+            if(!collision_filter_accepts(filter, c.category, c.mask)) continue;
+            if(!overlaps(c.x, c.y, c.x + c.width, c.y + c.height, area)) continue;
+
+            if(refs != NULL) refs[found] = i | COLLIDER_REF_DYNAMIC;
+            out[found++] = c;
+        }
+        return found;
+    }
+
+    for(int cy = y0; cy <= y1; cy++) {
+        for(int cx = x0; cx <= x1; cx++) {
+            uint32_t node = dyn->buckets[dynamic_index_bucket(cx, cy)];
+            for(; node != DYNAMIC_INDEX_NODE_NONE; node = dyn->nodes[node].next) {
+                const DynamicNode *n = &dyn->nodes[node];
+                if(n->cx != cx || n->cy != cy) continue;
+
+                Collider c = dyn->items[n->item];
+                if(!collision_filter_accepts(filter, c.category, c.mask)) continue;
+                if(!overlaps(c.x, c.y, c.x + c.width, c.y + c.height, area)) continue;
+
+                Rectangle fat = dyn->fat[n->item];
+                if(dynamic_cell(fmaxf(fat.x, area.x), dyn->cellOffsetX) != cx ||
+                   dynamic_cell(fmaxf(fat.y, area.y), dyn->cellOffsetY) != cy) {
+                    continue;
+                }
+
+                if(found == max) return found;
+                if(refs != NULL) refs[found] = n->item | COLLIDER_REF_DYNAMIC;
+                out[found++] = c;
+            }
+        }
+    }
+
+    return found;
+}
+
+static void dynamic_free(DynamicIndex *dyn) {
+    mem_free(dyn->items);
+    mem_free(dyn->fat);
+    mem_free(dyn->delta);
+    mem_free(dyn->moved);
+    mem_free(dyn->movedList);
+    mem_free(dyn->buckets);
+    mem_free(dyn->nodes);
+    *dyn = (DynamicIndex){0};
+}
+
+void collision_world_build(CollisionWorld *world, const Collider *statics, size_t count) {
+    StaticIndex index;
+    static_index_build(&index, statics, count);
+    collision_world_from_index(world, index);
+}
+
+void collision_world_from_index(CollisionWorld *world, StaticIndex statics) {
+    *world = (CollisionWorld){0};
+    world->statics = statics;
+
+    DynamicIndex *dyn = &world->dynamics;
+    dyn->freeNode = DYNAMIC_INDEX_NODE_NONE;
+    dyn->buckets = grow(NULL, DYNAMIC_INDEX_BUCKETS, sizeof(uint32_t));
+    for(size_t b = 0; b < DYNAMIC_INDEX_BUCKETS; b++) dyn->buckets[b] = DYNAMIC_INDEX_NODE_NONE;
+}
+
+void collision_world_free(CollisionWorld *world) {
+    static_index_free(&world->statics);
+    dynamic_free(&world->dynamics);
+    *world = (CollisionWorld){0};
+}
+
+ColliderRef collision_world_add_dynamic(CollisionWorld *world, Collider collider) {
+    DynamicIndex *dyn = &world->dynamics;
+    if(dyn->count == dyn->capacity) {
+        dyn->capacity = dyn->capacity == 0 ? DA_INIT_CAP : dyn->capacity*2;
+        dyn->items = grow(dyn->items, dyn->capacity, sizeof(Collider));
+        dyn->fat = grow(dyn->fat, dyn->capacity, sizeof(Rectangle));
+        dyn->delta = grow(dyn->delta, dyn->capacity, sizeof(Vector2));
+        dyn->moved = grow(dyn->moved, dyn->capacity, sizeof(bool));
+        dyn->movedList = grow(dyn->movedList, dyn->capacity, sizeof(uint32_t));
+    }
+
+    uint32_t i = dyn->count++;
+    dyn->items[i] = collider;
+    dyn->fat[i] = fat_box(collider);
+    dyn->delta[i] = (Vector2){0};
+    dyn->moved[i] = false;
+    dynamic_bin(dyn, i);
+
+    return i | COLLIDER_REF_DYNAMIC;
+}
+
+void collision_world_set_dynamic(CollisionWorld *world, ColliderRef ref, Collider collider) {
+    assert(ref & COLLIDER_REF_DYNAMIC);
+    DynamicIndex *dyn = &world->dynamics;
+    uint32_t i = ref & COLLIDER_REF_INDEX_MASK;
+
+    Collider old = dyn->items[i];
+    dyn->items[i] = collider;
+    dyn->delta[i].x += collider.x - old.x;
+    dyn->delta[i].y += collider.y - old.y;
+    if(!dyn->moved[i]) {
+        dyn->moved[i] = true;
+        dyn->movedList[dyn->movedCount++] = i;
+    }
+
+    if(!contains(dyn->fat[i], collider)) {
+        dynamic_unbin(dyn, i);
+        dyn->fat[i] = fat_box(collider);
+        dynamic_bin(dyn, i);
+        dyn->rebinned++;
+    }
+}
+
+void collision_world_shift(CollisionWorld *world, Vector2 delta) {
+    assert(fmodf(delta.x, DYNAMIC_INDEX_CELL_SIZE) == 0 && fmodf(delta.y, DYNAMIC_INDEX_CELL_SIZE) == 0);
+    static_index_shift(&world->statics, delta);
+
+    DynamicIndex *dyn = &world->dynamics;
+    for(size_t i = 0; i < dyn->count; i++) {
+        dyn->items[i].x += delta.x;
+        dyn->items[i].y += delta.y;
+        dyn->fat[i].x += delta.x;
+        dyn->fat[i].y += delta.y;
+    }
+    dyn->cellOffsetX += (int)(delta.x/DYNAMIC_INDEX_CELL_SIZE);
+    dyn->cellOffsetY += (int)(delta.y/DYNAMIC_INDEX_CELL_SIZE);
+}
+
+Vector2 collision_world_get_delta(const CollisionWorld *world, ColliderRef ref) {
+    if(ref == COLLIDER_REF_NONE || !(ref & COLLIDER_REF_DYNAMIC)) return (Vector2){0};
+    return world->dynamics.delta[ref & COLLIDER_REF_INDEX_MASK];
+}
+
+void collision_world_begin_tick(CollisionWorld *world) {
+    DynamicIndex *dyn = &world->dynamics;
+    for(size_t k = 0; k < dyn->movedCount; k++) {
+        uint32_t i = dyn->movedList[k];
+        dyn->delta[i] = (Vector2){0};
+        dyn->moved[i] = false;
+    }
+    dyn->movedCount = 0;
+    dyn->rebinned = 0;
+}
+
+Collider collision_world_get(const CollisionWorld *world, ColliderRef ref) {
+    if(ref & COLLIDER_REF_DYNAMIC) {
+        return world->dynamics.items[ref & COLLIDER_REF_INDEX_MASK];
+    }
+    if(ref & COLLIDER_REF_TILE) {
+        const Tilemap *map = world->tiles;
+        uint32_t tile = ref & COLLIDER_REF_INDEX_MASK;
+        return (Collider) {
+            .x = map->originX + (tile % map->cols)*map->tileSize,
+            .y = map->originY + (tile / map->cols)*map->tileSize,
+            .width = map->tileSize,
+            .height = map->tileSize,
+            .category = map->category,
+            .mask = COLLISION_LAYER_ALL,
+        };
+    }
+    return static_index_get(&world->statics, ref);
+}
+
+size_t collision_query(const CollisionWorld *world, Rectangle area, CollisionFilter filter,
+                       Collider *out, ColliderRef *refs, size_t max) {
+    size_t found = static_query(&world->statics, area, filter, refs, out, max);
+
+    found += dynamic_query(&world->dynamics, area, filter, out + found,
+                           refs != NULL ? refs + found : NULL, max - found);
+
+    const Tilemap *map = world->tiles;
+    if(map == NULL) return found;
+
+    size_t tiles = tilemap_query(map, area, filter, out + found, max - found);
+    if(refs != NULL) {
+        for(size_t k = found; k < found + tiles; k++) {
+            int col = (int)roundf((out[k].x - map->originX)/map->tileSize);
+            int row = (int)roundf((out[k].y - map->originY)/map->tileSize);
+            refs[k] = (uint32_t)(row*map->cols + col) | COLLIDER_REF_TILE;
+        }
+    }
+    found += tiles;
+
+    return found;
+}
+
+size_t collision_contacts(const Collider *candidates, const ColliderRef *refs, size_t count,
+                          Rectangle box, Vector2 motion, CollisionFilter filter, Contact *out, size_t max) {
+    if(max == 0) return 0;
+
+    bool anyAxis = motion.x == 0 && motion.y == 0;
+    size_t found = 0;
+
+    for(size_t i = 0; i < count; i++) {
+        Collider c = candidates[i];
+        if(!collision_filter_accepts(filter, c.category, c.mask)) continue;
+        if(!overlaps(c.x, c.y, c.x + c.width, c.y + c.height, box)) continue;
+
+        // the ways out of the collider allowed by the motion
+        Contact contact = {
+            .collider = c,
+            .ref = refs != NULL ? refs[i] : COLLIDER_REF_NONE,
+            .depth = INFINITY,
+        };
+        float left = box.x + box.width - c.x;
+        float right = c.x + c.width - box.x;
+        float up = box.y + box.height - c.y;
+        float down = c.y + c.height - box.y;
+
+        if((motion.x > 0 || anyAxis) && left < contact.depth) {
+            contact.depth = left;
+            contact.normal = (Vector2){ -1, 0 };
+        }
+        if((motion.x < 0 || anyAxis) && right < contact.depth) {
+            contact.depth = right;
+            contact.normal = (Vector2){ 1, 0 };
+        }
+        if((motion.y > 0 || anyAxis) && up < contact.depth) {
+            contact.depth = up;
+            contact.normal = (Vector2){ 0, -1 };
+        }
+        if((motion.y < 0 || anyAxis) && down < contact.depth) {
+            contact.depth = down;
+            contact.normal = (Vector2){ 0, 1 };
+        }
+
+        // insertion sort, the buffer is small
+        size_t k;
+        if(found < max) {
+            k = found++;
+        } else if(contact.depth > out[0].depth) {
+            for(size_t j = 1; j < found; j++) out[j - 1] = out[j];
+            k = found - 1;
+        } else {
+            continue;
+        }
+
+        while(k > 0 && out[k - 1].depth > contact.depth) {
+            out[k] = out[k - 1];
+            k--;
+        }
+        out[k] = contact;
+    }
+
+    return found;
+}
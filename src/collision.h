@@ -0,0 +1,211 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "raylib.h"
+
+// Categories a collider belongs to, and what its mask lets it interact with
+#define COLLISION_LAYER_SOLID (1u << 0)
+#define COLLISION_LAYER_PLAYER (1u << 1)
+#define COLLISION_LAYER_ENEMY (1u << 2)
+#define COLLISION_LAYER_PICKUP (1u << 3)
+#define COLLISION_LAYER_TRIGGER (1u << 4)
+#define COLLISION_LAYER_ONE_WAY (1u << 5)
+#define COLLISION_LAYER_PROJECTILE (1u << 6)
+#define COLLISION_LAYER_ALL 0xffffffffu
+
+typedef struct {
+    float x;
+    float y;
+    float width;
+    float height;
+
+    uint32_t category;
+    uint32_t mask;
+} Collider;
+
+typedef struct {
+    Collider *items;
+    size_t count;
+    size_t capacity;
+} Colliders;
+
+// Describes who is asking a query. A collider is only returned when each
+// side's category is in the other's mask.
+typedef struct {
+    uint32_t category;
+    uint32_t mask;
+} CollisionFilter;
+
+static inline bool collision_filter_accepts(CollisionFilter filter, uint32_t category, uint32_t mask) {
+    return (filter.mask & category) && (filter.category & mask);
+}
+
+// Identifies a collider of a CollisionWorld, the two high bits tell if it's
+// in the dynamic set or a tile (then it's the index of its first tile).
+typedef uint32_t ColliderRef;
+
+#define COLLIDER_REF_DYNAMIC 0x80000000u
+#define COLLIDER_REF_TILE 0x40000000u
+#define COLLIDER_REF_INDEX_MASK 0x3fffffffu
+#define COLLIDER_REF_NONE 0xffffffffu
+
+#define STATIC_INDEX_MAX_LEVELS 16
+
+// One level of the static grid as a CSR array, the items of the cell c are
+// cellItems[cellStart[c]..cellStart[c + 1]]
+typedef struct {
+    float cellSize;
+    int cols;
+    int rows;
+    const uint32_t *cellStart;
+    const uint32_t *cellItems;
+} StaticGrid;
+
+// Immutable index over colliders that never move. It's built once when the
+// level is loaded: the bounds and layers are stored as SoA and each collider
+// goes to the grid level whose cells are about its size, so it's in 4 cells
+// at most whether it's a ledge or a wall. Every level starts at the origin.
+//
+// The SoA is sorted along a Z-order curve, so colliders that are close in
+// the level are close in memory. Indices returned by the index are positions
+// in that order, source and position map them from and to the input order.
+typedef struct {
+    const float *minX;
+    const float *minY;
+    const float *maxX;
+    const float *maxY;
+    const uint32_t *category;
+    const uint32_t *mask;
+    size_t count;
+
+    const uint32_t *source; // input index of the item at each position
+    const uint32_t *position; // position of each input collider
+
+    float originX;
+    float originY;
+    StaticGrid levels[STATIC_INDEX_MAX_LEVELS]; // finest first, only the ones in use
+    int levelCount;
+
+    void *memory; // owns every array above, NULL when they are tables compiled in
+    size_t memorySize;
+    size_t mappedSize; // when memory is a file mapping of that size, 0 when it's malloc'd
+} StaticIndex;
+
+#define DYNAMIC_INDEX_CELL_SIZE 256
+#define DYNAMIC_INDEX_BUCKETS 4096 // must be a power of two
+#define DYNAMIC_INDEX_FAT_MARGIN 32 // how far a collider moves before it's binned again
+
+#define DYNAMIC_INDEX_NODE_NONE 0xffffffffu
+
+typedef struct {
+    uint32_t item;
+    int cx;
+    int cy;
+    uint32_t next;
+} DynamicNode;
+
+// The bucket a cell goes to, the nodes of the cells sharing it are told
+// apart by their cx and cy
+static inline uint32_t dynamic_index_bucket(int cx, int cy) {
+    return ((uint32_t)cx*73856093u ^ (uint32_t)cy*19349663u) & (DYNAMIC_INDEX_BUCKETS - 1);
+}
+
+// Colliders that move, binned in a spatial hash by a box a bit bigger than
+// them. Moving inside that fat box only updates the bounds, the grid is only
+// touched when a collider leaves it.
+typedef struct {
+    Collider *items;
+    Rectangle *fat;
+    Vector2 *delta; // movement since the last collision_world_begin_tick
+    bool *moved;
+    size_t count;
+    size_t capacity;
+
+    uint32_t *buckets;
+    int cellOffsetX; // cells the world was shifted by, see collision_world_shift
+    int cellOffsetY;
+    DynamicNode *nodes;
+    size_t nodeCount;
+    size_t nodeCapacity;
+    uint32_t freeNode;
+
+    // items moved this tick, so the next tick only resets those
+    uint32_t *movedList;
+    size_t movedCount;
+    size_t rebinned;
+} DynamicIndex;
+
+typedef struct Tilemap Tilemap;
+
+// Static colliders go to the prebuilt index, the ones that move (platforms,
+// spawned objects) to a spatial hash that is cheap to update. Grid levels can
+// also attach their solid tiles, the tilemap isn't owned.
+typedef struct {
+    StaticIndex statics;
+    DynamicIndex dynamics;
+    const Tilemap *tiles; // optional
+} CollisionWorld;
+
+void static_index_build(StaticIndex *index, const Collider *colliders, size_t count);
+// Same as static_index_build but the items keep the input order
+void static_index_build_in_order(StaticIndex *index, const Collider *colliders, size_t count);
+void static_index_free(StaticIndex *index);
+// Adds delta to every collider, the grid stays as it is
+void static_index_shift(StaticIndex *index, Vector2 delta);
+Collider static_index_get(const StaticIndex *index, uint32_t i);
+// Writes up to max indices of the colliders overlapping area, each one once
+size_t static_index_query(const StaticIndex *index, Rectangle area, CollisionFilter filter, uint32_t *out, size_t max);
+// Same as static_index_query with the colliders instead of their indices
+size_t static_index_query_colliders(const StaticIndex *index, Rectangle area, CollisionFilter filter,
+                                    Collider *out, size_t max);
+
+void collision_world_build(CollisionWorld *world, const Collider *statics, size_t count);
+// Same with an index built beforehand, the world takes it over
+void collision_world_from_index(CollisionWorld *world, StaticIndex statics);
+void collision_world_free(CollisionWorld *world);
+
+ColliderRef collision_world_add_dynamic(CollisionWorld *world, Collider collider);
+void collision_world_set_dynamic(CollisionWorld *world, ColliderRef ref, Collider collider);
+Collider collision_world_get(const CollisionWorld *world, ColliderRef ref);
+
+// Adds delta to every static and dynamic collider when the origin of the
+// simulation moves. delta has to be a multiple of DYNAMIC_INDEX_CELL_SIZE,
+// then the hash only needs to know how many cells it moved. The tilemap
+// isn't owned and has to be shifted on its own.
+void collision_world_shift(CollisionWorld *world, Vector2 delta);
+
+// How much a dynamic collider moved this tick, zero for anything else. Riders
+// use it to follow what they stand on without querying again.
+Vector2 collision_world_get_delta(const CollisionWorld *world, ColliderRef ref);
+
+// Forgets the movement of the last tick, the cost is the number of colliders
+// that moved
+void collision_world_begin_tick(CollisionWorld *world);
+
+// A candidate overlapping a box and how to push the box out of it. normal
+// points away from the collider and depth is how far the box has to move
+// along it to stop overlapping.
+typedef struct {
+    Collider collider;
+    ColliderRef ref;
+    Vector2 normal;
+    float depth;
+} Contact;
+
+// Merges the overlaps of every set into out, refs is optional. Returns the
+// number of colliders written, never more than max.
+size_t collision_query(const CollisionWorld *world, Rectangle area, CollisionFilter filter,
+                       Collider *out, ColliderRef *refs, size_t max);
+
+// Writes the candidates overlapping box as contacts sorted from the smallest
+// translation to the largest, refs is optional. The contacts push the box
+// back against motion on its non zero axes, with no motion at all they take
+// the shortest way out. When there are more than max overlaps the shallowest
+// ones are dropped.
+size_t collision_contacts(const Collider *candidates, const ColliderRef *refs, size_t count,
+                          Rectangle box, Vector2 motion, CollisionFilter filter, Contact *out, size_t max);
+
+#endif // COLLISION_H
@@ -0,0 +1,281 @@
+#include <math.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "compact.h"
+#include "utils.h"
+#include "mem.h"
+
+// below it the sums of the decoder are exact in a float
+#define COMPACT_MAX_COORD (1 << 23)
+
+typedef struct {
+    uint32_t chunk;
+    uint32_t category;
+    uint32_t mask;
+    uint32_t morton;
+    uint32_t index;
+} SortItem;
+
+static bool fits(Collider c) {
+    return c.x == floorf(c.x) && c.y == floorf(c.y) &&
+           c.width == floorf(c.width) && c.height == floorf(c.height) &&
+           c.width >= 0 && c.height >= 0 &&
+           c.width <= COMPACT_CHUNK_SIZE && c.height <= COMPACT_CHUNK_SIZE &&
+           fabsf(c.x) < COMPACT_MAX_COORD && fabsf(c.y) < COMPACT_MAX_COORD;
+}
+
+// The low 16 bits of v on the even bits
+static uint32_t spread_bits(uint32_t v) {
+    v &= 0xffff;
+    v = (v | v << 8) & 0x00ff00ffu;
+    v = (v | v << 4) & 0x0f0f0f0fu;
+    v = (v | v << 2) & 0x33333333u;
+    v = (v | v << 1) & 0x55555555u;
+    return v;
+}
+
+static int compare_sort_items(const void *a, const void *b) {
+    const SortItem *ia = a, *ib = b;
+    if(ia->chunk != ib->chunk) return ia->chunk < ib->chunk ? -1 : 1;
+    if(ia->category != ib->category) return ia->category < ib->category ? -1 : 1;
+    if(ia->mask != ib->mask) return ia->mask < ib->mask ? -1 : 1;
+    if(ia->morton != ib->morton) return ia->morton < ib->morton ? -1 : 1;
+    return (ia->index > ib->index) - (ia->index < ib->index);
+}
+
+static int chunk_coord(float value, float origin, int chunks) {
+    int c = (int)floorf((value - origin)/COMPACT_CHUNK_SIZE);
+    if(c < 0) return 0;
+    if(c >= chunks) return chunks - 1;
+    return c;
+}
+
+void compact_colliders_build(CompactColliders *cc, const Collider *colliders, size_t count) {
+    *cc = (CompactColliders){0};
+
+    // chunks are placed by the top left corners only
+    Colliders fallback = {0};
+    size_t eligible = 0;
+    float minX = 0, minY = 0, maxX = 0, maxY = 0;
+    for(size_t i = 0; i < count; i++) {
+        Collider c = colliders[i];
+        if(!fits(c)) {
+            da_append(&fallback, c);
+            continue;
+        }
+
+        if(eligible == 0 || c.x < minX) minX = c.x;
+        if(eligible == 0 || c.y < minY) minY = c.y;
+        if(eligible == 0 || c.x > maxX) maxX = c.x;
+        if(eligible == 0 || c.y > maxY) maxY = c.y;
+        eligible++;
+    }
+    static_index_build(&cc->fallback, fallback.items, fallback.count);
+    da_free(&fallback);
+    if(eligible == 0) return;
+
+    cc->originX = minX;
+    cc->originY = minY;
+    cc->cols = (int)((maxX - minX)/COMPACT_CHUNK_SIZE) + 1;
+    cc->rows = (int)((maxY - minY)/COMPACT_CHUNK_SIZE) + 1;
+
+    // sorted by chunk and layers so they can be cut in blocks, then along a
+    // Z-order curve so the blocks are tight
+    SortItem *sorted = mem_alloc(MEM_TAG_SCRATCH, eligible*sizeof(SortItem));
+    assert(sorted != NULL && "No enough ram");
+    size_t n = 0;
+    for(size_t i = 0; i < count; i++) {
+        Collider c = colliders[i];
+        if(!fits(c)) continue;
+
+        int cx = chunk_coord(c.x, cc->originX, cc->cols);
+        int cy = chunk_coord(c.y, cc->originY, cc->rows);
+        uint32_t lx = (uint32_t)(c.x - (cc->originX + cx*COMPACT_CHUNK_SIZE));
+        uint32_t ly = (uint32_t)(c.y - (cc->originY + cy*COMPACT_CHUNK_SIZE));
+        sorted[n++] = (SortItem) {
+            .chunk = cy*cc->cols + cx,
+            .category = c.category,
+            .mask = c.mask,
+            .morton = spread_bits(lx) | spread_bits(ly) << 1,
+            .index = i,
+        };
+    }
+    qsort(sorted, eligible, sizeof(SortItem), compare_sort_items);
+
+    size_t chunkCount = (size_t)cc->cols*cc->rows;
+    cc->items = mem_calloc(MEM_TAG_LEVEL, eligible + 3, sizeof(CompactCollider));
+    cc->blocks = mem_alloc(MEM_TAG_LEVEL, eligible*sizeof(CompactBlock));
+    cc->chunkStart = mem_calloc(MEM_TAG_LEVEL, chunkCount + 1, sizeof(uint32_t));
+    assert(cc->items != NULL && cc->blocks != NULL && cc->chunkStart != NULL && "No enough ram");
+    cc->count = eligible;
+
+    CompactBlock *block = NULL;
+    for(size_t i = 0; i < eligible; i++) {
+        SortItem s = sorted[i];
+        Collider c = colliders[s.index];
+        float ox = cc->originX + (s.chunk % cc->cols)*COMPACT_CHUNK_SIZE;
+        float oy = cc->originY + (s.chunk / cc->cols)*COMPACT_CHUNK_SIZE;
+
+        bool sameRun = i > 0 && sorted[i - 1].chunk == s.chunk &&
+                       sorted[i - 1].category == s.category && sorted[i - 1].mask == s.mask;
+        if(!sameRun || block->count == COMPACT_BLOCK_SIZE) {
+            block = &cc->blocks[cc->blockCount++];
+            *block = (CompactBlock) {
+                .minX = c.x,
+                .minY = c.y,
+                .maxX = c.x + c.width,
+                .maxY = c.y + c.height,
+                .category = s.category,
+                .mask = s.mask,
+                .start = i,
+            };
+            cc->chunkStart[s.chunk + 1]++;
+        }
+
+        block->minX = fminf(block->minX, c.x);
+        block->minY = fminf(block->minY, c.y);
+        block->maxX = fmaxf(block->maxX, c.x + c.width);
+        block->maxY = fmaxf(block->maxY, c.y + c.height);
+        block->count++;
+
+        cc->items[i] = (CompactCollider) {
+            .x = (int16_t)(c.x - ox),
+            .y = (int16_t)(c.y - oy),
+            .width = (uint16_t)c.width,
+            .height = (uint16_t)c.height,
+        };
+    }
+    for(size_t c = 0; c < chunkCount; c++) cc->chunkStart[c + 1] += cc->chunkStart[c];
+
+    cc->blocks = mem_realloc(MEM_TAG_LEVEL, cc->blocks, cc->blockCount*sizeof(CompactBlock));
+    assert(cc->blocks != NULL && "No enough ram");
+    mem_free(sorted);
+}
+
+void compact_colliders_free(CompactColliders *cc) {
+    mem_free(cc->items);
+    mem_free(cc->blocks);
+    mem_free(cc->chunkStart);
+    static_index_free(&cc->fallback);
+    *cc = (CompactColliders){0};
+}
+
+void compact_colliders_shift(CompactColliders *cc, Vector2 delta) {
+    cc->originX += delta.x;
+    cc->originY += delta.y;
+    for(size_t b = 0; b < cc->blockCount; b++) {
+        cc->blocks[b].minX += delta.x;
+        cc->blocks[b].minY += delta.y;
+        cc->blocks[b].maxX += delta.x;
+        cc->blocks[b].maxY += delta.y;
+    }
+    static_index_shift(&cc->fallback, delta);
+}
+
+float compact_colliders_bytes_per_item(const CompactColliders *cc) {
+    size_t total = cc->count + cc->fallback.count;
+    if(total == 0) return 0;
+
+    // the fallback index counted as its bounds and layers
+    size_t bytes = cc->count*sizeof(CompactCollider) + cc->blockCount*sizeof(CompactBlock) +
+                   ((size_t)cc->cols*cc->rows + 1)*sizeof(uint32_t) +
+                   cc->fallback.count*(4*sizeof(float) + 2*sizeof(uint32_t));
+    return (float)bytes/total;
+}
+
+// Bit j is set when items[j] overlaps area. The sums are done on integers and
+// the origin added last, the same floats a Collider would give.
+static unsigned overlap4(const CompactCollider *items, float ox, float oy, Rectangle area) {
+#ifdef __SSE2__
+    // [x0 y0 w0 h0 x1 y1 w1 h1] [x2 y2 w2 h2 x3 y3 w3 h3] to one register per field
+    __m128i a = _mm_loadu_si128((const __m128i*)items);
+    __m128i b = _mm_loadu_si128((const __m128i*)(items + 2));
+    __m128i t0 = _mm_unpacklo_epi16(a, b);
+    __m128i t1 = _mm_unpackhi_epi16(a, b);
+    __m128i xy = _mm_unpacklo_epi16(t0, t1);
+    __m128i wh = _mm_unpackhi_epi16(t0, t1);
+
+    __m128i x = _mm_srai_epi32(_mm_unpacklo_epi16(xy, xy), 16);
+    __m128i y = _mm_srai_epi32(_mm_unpackhi_epi16(xy, xy), 16);
+    __m128i w = _mm_srli_epi32(_mm_unpacklo_epi16(wh, wh), 16);
+    __m128i h = _mm_srli_epi32(_mm_unpackhi_epi16(wh, wh), 16);
+
+    __m128 vox = _mm_set1_ps(ox), voy = _mm_set1_ps(oy);
+    __m128 minX = _mm_add_ps(_mm_cvtepi32_ps(x), vox);
+    __m128 minY = _mm_add_ps(_mm_cvtepi32_ps(y), voy);
+    __m128 maxX = _mm_add_ps(_mm_cvtepi32_ps(_mm_add_epi32(x, w)), vox);
+    __m128 maxY = _mm_add_ps(_mm_cvtepi32_ps(_mm_add_epi32(y, h)), voy);
+
+    __m128 hit = _mm_and_ps(_mm_cmplt_ps(minX, _mm_set1_ps(area.x + area.width)),
+                            _mm_cmpgt_ps(maxX, _mm_set1_ps(area.x)));
+    hit = _mm_and_ps(hit, _mm_cmplt_ps(minY, _mm_set1_ps(area.y + area.height)));
+    hit = _mm_and_ps(hit, _mm_cmpgt_ps(maxY, _mm_set1_ps(area.y)));
+    return _mm_movemask_ps(hit);
+#else
+    unsigned bits = 0;
+    for(int j = 0; j < 4; j++) {
+        CompactCollider c = items[j];
+        float minX = c.x + ox, maxX = (c.x + c.width) + ox;
+        float minY = c.y + oy, maxY = (c.y + c.height) + oy;
+        if(minX < area.x + area.width && maxX > area.x && minY < area.y + area.height && maxY > area.y) {
+            bits |= 1u << j;
+        }
+    }
+    return bits;
+#endif
+}
+
+size_t compact_colliders_query(const CompactColliders *cc, Rectangle area, CollisionFilter filter,
+                               Collider *out, size_t max) {
+    size_t found = static_index_query_colliders(&cc->fallback, area, filter, out, max);
+    if(cc->count == 0) return found;
+
+    // a collider can reach up to a chunk past the one of its corner
+    int x0 = chunk_coord(area.x - COMPACT_CHUNK_SIZE, cc->originX, cc->cols);
+    int x1 = chunk_coord(area.x + area.width, cc->originX, cc->cols);
+    int y0 = chunk_coord(area.y - COMPACT_CHUNK_SIZE, cc->originY, cc->rows);
+    int y1 = chunk_coord(area.y + area.height, cc->originY, cc->rows);
+
+    for(int cy = y0; cy <= y1; cy++) {
+        for(int cx = x0; cx <= x1; cx++) {
+            size_t chunk = (size_t)cy*cc->cols + cx;
+            float ox = cc->originX + cx*COMPACT_CHUNK_SIZE;
+            float oy = cc->originY + cy*COMPACT_CHUNK_SIZE;
+
+            for(uint32_t b = cc->chunkStart[chunk]; b < cc->chunkStart[chunk + 1]; b++) {
+                const CompactBlock *block = &cc->blocks[b];
+                if(!collision_filter_accepts(filter, block->category, block->mask)) continue;
+                if(!(block->minX < area.x + area.width && block->maxX > area.x &&
+                     block->minY < area.y + area.height && block->maxY > area.y)) {
+                    continue;
+                }
+
+                for(uint32_t k = 0; k < block->count; k += 4) {
+                    const CompactCollider *items = &cc->items[block->start + k];
+                    unsigned bits = overlap4(items, ox, oy, area);
+                    if(block->count - k < 4) bits &= (1u << (block->count - k)) - 1;
+
+                    for(; bits != 0; bits &= bits - 1) {
+                        if(found == max) return found;
+                        CompactCollider c = items[__builtin_ctz(bits)];
+                        out[found++] = (Collider) {
+                            .x = c.x + ox,
+                            .y = c.y + oy,
+                            .width = c.width,
+                            .height = c.height,
+                            .category = block->category,
+                            .mask = block->mask,
+                        };
+                    }
+                }
+            }
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,70 @@
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <stdint.h>
+#include "raylib.h"
+#include "collision.h"
+
+#define COMPACT_CHUNK_SIZE 4096 // also the biggest width or height stored compact
+#define COMPACT_BLOCK_SIZE 32
+
+// 8 bytes instead of the 24 of a Collider, the position is relative to the
+// origin of the chunk holding the top left corner
+typedef struct {
+    int16_t x;
+    int16_t y;
+    uint16_t width;
+    uint16_t height;
+} CompactCollider;
+
+// A run of colliders of the same chunk and layers, with their bounds so a
+// query can skip it without decoding anything
+typedef struct {
+    float minX;
+    float minY;
+    float maxX;
+    float maxY;
+    uint32_t category;
+    uint32_t mask;
+    uint32_t start;
+    uint32_t count;
+} CompactBlock;
+
+// Read only storage for huge static levels. Colliders authored on integer
+// coordinates are quantized without loss, so a query returns exactly what
+// the float colliders would. The others (fractional or bigger than a chunk)
+// are kept as floats in a static index of their own.
+//
+// Only the bench builds it for now, the collision world always queries a
+// StaticIndex. On the bench level it takes 9.18 bytes per collider against
+// the 8 of a CompactCollider, the blocks and the chunk table are the rest.
+typedef struct {
+    CompactCollider *items; // padded so a block can always be read 4 by 4
+    size_t count;
+
+    CompactBlock *blocks;
+    size_t blockCount;
+
+    // the blocks of the chunk c are blocks[chunkStart[c]..chunkStart[c + 1]]
+    uint32_t *chunkStart;
+    float originX;
+    float originY;
+    int cols;
+    int rows;
+
+    StaticIndex fallback;
+} CompactColliders;
+
+void compact_colliders_build(CompactColliders *cc, const Collider *colliders, size_t count);
+void compact_colliders_free(CompactColliders *cc);
+// The items are relative to their chunk, only the origins and bounds move
+void compact_colliders_shift(CompactColliders *cc, Vector2 delta);
+
+// Bytes used per collider, the blocks and chunks included
+float compact_colliders_bytes_per_item(const CompactColliders *cc);
+
+// Writes up to max colliders overlapping area, decoded
+size_t compact_colliders_query(const CompactColliders *cc, Rectangle area, CollisionFilter filter,
+                               Collider *out, size_t max);
+
+#endif // COMPACT_H
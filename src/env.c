@@ -0,0 +1,133 @@
+#include <math.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "env.h"
+#include "player.h"
+#include "raymath.h"
+#include "mem.h"
+
+#define ENV_STEP_GRAIN 256 // environments per job
+
+static void *env_alloc(size_t size) {
+    void *ptr = mem_calloc(MEM_TAG_PHYSICS, 1, size);
+    assert(ptr != NULL && "No enough ram");
+    return ptr;
+}
+
+static float goal_distance(const Envs *envs, const Player *player) {
+    return Vector2Distance(player->pos, envs->config.goal);
+}
+
+static void env_reset_one(Envs *envs, size_t i) {
+    envs->players[i] = (Player) {
+        .pos = envs->config.spawn,
+        .dir = PLAYER_DIR_RIGHT,
+        .riding = COLLIDER_REF_NONE,
+    };
+    envs->prevActions[i] = 0;
+    envs->steps[i] = 0;
+}
+
+static void env_observe(Envs *envs, size_t i) {
+    const Player *p = &envs->players[i];
+    float *obs = &envs->observations[i*ENV_OBS_SIZE];
+
+    obs[0] = p->pos.x;
+    obs[1] = p->pos.y;
+    obs[2] = p->vel.x;
+    obs[3] = p->vel.y;
+    obs[4] = p->isOnFloor;
+    obs[5] = p->huggingWall;
+    obs[6] = p->jumping;
+    obs[7] = p->dashing;
+}
+
+static void envs_step_range(void *data, size_t begin, size_t end) {
+    Envs *envs = data;
+
+    for(size_t i = begin; i < end; i++) {
+        Player *player = &envs->players[i];
+        uint8_t action = envs->actions[i];
+        uint8_t prev = envs->prevActions[i];
+
+        PlayerInput input = {
+            .left = action & ENV_ACTION_LEFT,
+            .right = action & ENV_ACTION_RIGHT,
+            .jumpPressed = (action & ENV_ACTION_JUMP) && !(prev & ENV_ACTION_JUMP),
+            .jumpReleased = !(action & ENV_ACTION_JUMP) && (prev & ENV_ACTION_JUMP),
+            .dashPressed = (action & ENV_ACTION_DASH) && !(prev & ENV_ACTION_DASH),
+        };
+
+        float before = goal_distance(envs, player);
+        player_step(player, envs->level, input, envs->config.dt);
+        float after = goal_distance(envs, player);
+
+        envs->prevActions[i] = action;
+        envs->steps[i]++;
+
+        // rewarded by every 100px of progress towards the goal
+        float reward = (before - after)/100;
+        bool done = false;
+
+        if(after <= envs->config.goalRadius) {
+            reward += ENV_GOAL_REWARD;
+            done = true;
+        } else if(envs->steps[i] >= envs->config.maxSteps) {
+            done = true;
+        }
+
+        if(done) env_reset_one(envs, i);
+
+        envs->rewards[i] = reward;
+        envs->dones[i] = done;
+        env_observe(envs, i);
+    }
+}
+
+void envs_create(Envs *envs, size_t count, const CollisionWorld *level, EnvConfig config, JobSystem *jobs) {
+    *envs = (Envs) {
+        .count = count,
+        .config = config,
+        .level = level,
+        .jobs = jobs,
+    };
+
+    envs->players = env_alloc(count*sizeof(Player));
+    envs->prevActions = env_alloc(count*sizeof(uint8_t));
+    envs->steps = env_alloc(count*sizeof(uint32_t));
+    envs->observations = env_alloc(count*ENV_OBS_SIZE*sizeof(float));
+    envs->rewards = env_alloc(count*sizeof(float));
+    envs->dones = env_alloc(count*sizeof(uint8_t));
+
+    envs_reset(envs);
+}
+
+void envs_destroy(Envs *envs) {
+    mem_free(envs->players);
+    mem_free(envs->prevActions);
+    mem_free(envs->steps);
+    mem_free(envs->observations);
+    mem_free(envs->rewards);
+    mem_free(envs->dones);
+    *envs = (Envs){0};
+}
+
+void envs_reset(Envs *envs) {
+    for(size_t i = 0; i < envs->count; i++) {
+        env_reset_one(envs, i);
+        envs->rewards[i] = 0;
+        envs->dones[i] = 0;
+        env_observe(envs, i);
+    }
+}
+
+void envs_step(Envs *envs, const uint8_t *actions) {
+    envs->actions = actions;
+    if(envs->jobs != NULL) {
+        jobs_parallel_for(envs->jobs, envs->count, ENV_STEP_GRAIN, envs_step_range, envs);
+    } else {
+        envs_step_range(envs, 0, envs->count);
+    }
+    envs->actions = NULL;
+}
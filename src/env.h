@@ -0,0 +1,58 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include <stdint.h>
+#include "raylib.h"
+#include "game.h"
+#include "jobs.h"
+
+// Headless copies of the game used to train bots. Every environment has its
+// own player over the same level and all of them are stepped at once.
+
+#define ENV_ACTION_LEFT (1 << 0)
+#define ENV_ACTION_RIGHT (1 << 1)
+#define ENV_ACTION_JUMP (1 << 2) // held, the press and release are detected
+#define ENV_ACTION_DASH (1 << 3)
+
+// pos.x, pos.y, vel.x, vel.y, isOnFloor, huggingWall, jumping, dashing
+#define ENV_OBS_SIZE 8
+
+#define ENV_GOAL_REWARD 10.0f
+
+typedef struct {
+    Vector2 spawn;
+    Vector2 goal;
+    float goalRadius;
+    float dt; // fixed timestep of every step
+    uint32_t maxSteps; // episode length before it's reset
+} EnvConfig;
+
+typedef struct {
+    size_t count;
+    EnvConfig config;
+    const CollisionWorld *level;
+    JobSystem *jobs;
+
+    Player *players;
+    uint8_t *prevActions;
+    uint32_t *steps;
+
+    // outputs of the last step, contiguous and indexed by environment
+    float *observations; // count*ENV_OBS_SIZE
+    float *rewards;
+    uint8_t *dones;
+
+    const uint8_t *actions;
+} Envs;
+
+// All the memory is allocated here, stepping doesn't allocate
+void envs_create(Envs *envs, size_t count, const CollisionWorld *level, EnvConfig config, JobSystem *jobs);
+void envs_destroy(Envs *envs);
+
+void envs_reset(Envs *envs);
+
+// actions has one ENV_ACTION_* mask per environment. Environments that end
+// (goal reached or out of steps) are reset right away and report done.
+void envs_step(Envs *envs, const uint8_t *actions);
+
+#endif // ENV_H
@@ -2,20 +2,15 @@
 #define GAME_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include "raylib.h"
-
-typedef struct {
-    float x;
-    float y;
-    float width;
-    float height;
-} Collider;
-
-typedef struct {
-    Collider *items;
-    size_t count;
-    size_t capacity;
-} Colliders;
+#include "collision.h"
+#include "trigger.h"
+#include "moving.h"
+#include "tilemap.h"
+#include "particles.h"
+#include "projectiles.h"
+#include "jobs.h"
 
 #define PLAYER_DIR_LEFT -1
 #define PLAYER_DIR_RIGHT 1
@@ -25,6 +20,7 @@ typedef struct {
     Vector2 vel;
 
     bool isOnFloor;
+    ColliderRef riding; // what the player stands on, carried along when it moves
 
     bool jumping;
     float jumpTime;
@@ -34,20 +30,33 @@ typedef struct {
 
     bool huggingWall;
 
+    // what happened during the last tick, for the effects
+    bool dashStarted;
+    bool landed;
+
     int dir; // 1 for right, -1 for left, default 1
 } Player;
 
 typedef struct {
-    Rectangle *items;
-    size_t count;
-    size_t capacity;
-} Platforms;
-
-typedef struct {
-    Colliders colliders;
-    Platforms platforms;
+    CollisionWorld collision;
+    MovingPlatforms moving;
+    Tilemap tiles;
+    ParticleSystem particles;
+    Projectiles projectiles;
     Player player;
     Camera2D camera;
+
+    // the particles and projectiles integrate on it
+    JobSystem *jobs;
+
+    TriggerSet triggers;
+    TriggerTracker playerTriggers;
+    Vector2 spawn; // where the player comes back after a hazard
+
+    // where the simulation origin is in the world. Every position is relative
+    // to it, so they stay small and precise however far the player goes.
+    int64_t originX;
+    int64_t originY;
 } Game;
 
 #endif // GAME_H
@@ -0,0 +1,302 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <assert.h>
+
+#include "jobs.h"
+#include "mem.h"
+
+typedef struct {
+    Job job;
+    JobCounter *counter;
+} QueuedJob;
+
+// The owner pushes and pops at the bottom, the other threads steal from the
+// top. Jobs waiting for a dependency are put back at the top so the owner
+// runs everything else first.
+typedef struct {
+    pthread_mutex_t mutex;
+    QueuedJob items[JOBS_DEQUE_CAPACITY];
+    size_t top;
+    size_t bottom;
+} JobDeque;
+
+typedef struct {
+    JobSystem *js;
+    int index;
+    pthread_t thread;
+    unsigned int seed;
+} Worker;
+
+struct JobSystem {
+    int threadCount;
+    JobDeque deques[JOBS_MAX_THREADS];
+    Worker workers[JOBS_MAX_THREADS];
+
+    atomic_size_t queued;
+    atomic_int sleeping;
+    atomic_bool quit;
+    pthread_mutex_t sleepMutex;
+    pthread_cond_t wakeUp;
+};
+
+static _Thread_local int workerIndex = 0;
+
+static bool deque_push_bottom(JobDeque *dq, QueuedJob item) {
+    bool pushed = false;
+    pthread_mutex_lock(&dq->mutex);
+    if(dq->bottom - dq->top < JOBS_DEQUE_CAPACITY) {
+        dq->items[dq->bottom++ & (JOBS_DEQUE_CAPACITY - 1)] = item;
+        pushed = true;
+    }
+    pthread_mutex_unlock(&dq->mutex);
+    return pushed;
+}
+
+static bool deque_push_top(JobDeque *dq, QueuedJob item) {
+    bool pushed = false;
+    pthread_mutex_lock(&dq->mutex);
+    if(dq->bottom - dq->top < JOBS_DEQUE_CAPACITY) {
+        dq->items[--dq->top & (JOBS_DEQUE_CAPACITY - 1)] = item;
+        pushed = true;
+    }
+    pthread_mutex_unlock(&dq->mutex);
+    return pushed;
+}
+
+static bool deque_pop_bottom(JobDeque *dq, QueuedJob *out) {
+    bool popped = false;
+    pthread_mutex_lock(&dq->mutex);
+    if(dq->bottom != dq->top) {
+        *out = dq->items[--dq->bottom & (JOBS_DEQUE_CAPACITY - 1)];
+        popped = true;
+    }
+    pthread_mutex_unlock(&dq->mutex);
+    return popped;
+}
+
+static bool deque_steal_top(JobDeque *dq, QueuedJob *out) {
+    bool stolen = false;
+    pthread_mutex_lock(&dq->mutex);
+    if(dq->bottom != dq->top) {
+        *out = dq->items[dq->top++ & (JOBS_DEQUE_CAPACITY - 1)];
+        stolen = true;
+    }
+    pthread_mutex_unlock(&dq->mutex);
+    return stolen;
+}
+
+static void wake_workers(JobSystem *js) {
+    if(atomic_load(&js->sleeping) > 0) {
+        pthread_mutex_lock(&js->sleepMutex);
+        pthread_cond_broadcast(&js->wakeUp);
+        pthread_mutex_unlock(&js->sleepMutex);
+    }
+}
+
+static bool find_job(JobSystem *js, int self, QueuedJob *out) {
+    if(atomic_load(&js->queued) == 0) return false;
+
+    if(deque_pop_bottom(&js->deques[self], out)) {
+        atomic_fetch_sub(&js->queued, 1);
+        return true;
+    }
+
+    Worker *w = &js->workers[self];
+    int start = rand_r(&w->seed) % js->threadCount;
+    for(int i = 0; i < js->threadCount; i++) {
+        int victim = (start + i) % js->threadCount;
+        if(victim == self) continue;
+
+        if(deque_steal_top(&js->deques[victim], out)) {
+            atomic_fetch_sub(&js->queued, 1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void execute(JobSystem *js, int self, QueuedJob *item) {
+    JobCounter *dep = item->job.dependency;
+    if(dep != NULL && atomic_load(&dep->pending) > 0) {
+        // not ready yet, put it where it will be picked last
+        if(deque_push_top(&js->deques[self], *item)) {
+            atomic_fetch_add(&js->queued, 1);
+            return;
+        }
+
+        while(atomic_load(&dep->pending) > 0) {
+            QueuedJob other;
+            if(find_job(js, self, &other)) execute(js, self, &other);
+            else sched_yield();
+        }
+    }
+
+    item->job.fn(item->job.data);
+
+    if(item->counter != NULL) {
+        atomic_fetch_sub(&item->counter->pending, 1);
+    }
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = arg;
+    JobSystem *js = w->js;
+    workerIndex = w->index;
+
+    while(!atomic_load(&js->quit)) {
+        QueuedJob item;
+        if(find_job(js, w->index, &item)) {
+            execute(js, w->index, &item);
+            continue;
+        }
+
+        pthread_mutex_lock(&js->sleepMutex);
+        atomic_fetch_add(&js->sleeping, 1);
+        while(atomic_load(&js->queued) == 0 && !atomic_load(&js->quit)) {
+            pthread_cond_wait(&js->wakeUp, &js->sleepMutex);
+        }
+        atomic_fetch_sub(&js->sleeping, 1);
+        pthread_mutex_unlock(&js->sleepMutex);
+    }
+
+    return NULL;
+}
+
+JobSystem *jobs_create(int threadCount) {
+    if(threadCount <= 0) {
+        threadCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if(threadCount < 1) threadCount = 1;
+    if(threadCount > JOBS_MAX_THREADS) threadCount = JOBS_MAX_THREADS;
+
+    JobSystem *js = mem_calloc(MEM_TAG_PHYSICS, 1, sizeof(JobSystem));
+    assert(js != NULL && "No enough ram");
+
+    js->threadCount = threadCount;
+    pthread_mutex_init(&js->sleepMutex, NULL);
+    pthread_cond_init(&js->wakeUp, NULL);
+
+    for(int i = 0; i < threadCount; i++) {
+        pthread_mutex_init(&js->deques[i].mutex, NULL);
+        js->workers[i].js = js;
+        js->workers[i].index = i;
+        js->workers[i].seed = i*2654435761u + 1;
+    }
+
+    // worker 0 is the calling thread
+    for(int i = 1; i < threadCount; i++) {
+        pthread_create(&js->workers[i].thread, NULL, worker_main, &js->workers[i]);
+    }
+
+    return js;
+}
+
+void jobs_destroy(JobSystem *js) {
+    pthread_mutex_lock(&js->sleepMutex);
+    atomic_store(&js->quit, true);
+    pthread_cond_broadcast(&js->wakeUp);
+    pthread_mutex_unlock(&js->sleepMutex);
+
+    for(int i = 1; i < js->threadCount; i++) {
+        pthread_join(js->workers[i].thread, NULL);
+    }
+
+    for(int i = 0; i < js->threadCount; i++) {
+        pthread_mutex_destroy(&js->deques[i].mutex);
+    }
+    pthread_mutex_destroy(&js->sleepMutex);
+    pthread_cond_destroy(&js->wakeUp);
+    mem_free(js);
+}
+
+int jobs_thread_count(const JobSystem *js) {
+    return js->threadCount;
+}
+
+int jobs_worker_index(void) {
+    return workerIndex;
+}
+
+void jobs_run(JobSystem *js, const Job *jobs, size_t count, JobCounter *counter) {
+    int self = workerIndex;
+    if(counter != NULL) {
+        atomic_fetch_add(&counter->pending, count);
+    }
+
+    for(size_t i = 0; i < count; i++) {
+        QueuedJob item = { .job = jobs[i], .counter = counter };
+
+        if(deque_push_bottom(&js->deques[self], item)) {
+            atomic_fetch_add(&js->queued, 1);
+        } else {
+            // the deque is full, do the work here instead of allocating
+            execute(js, self, &item);
+        }
+    }
+
+    wake_workers(js);
+}
+
+void jobs_wait(JobSystem *js, JobCounter *counter) {
+    int self = workerIndex;
+    while(atomic_load(&counter->pending) > 0) {
+        QueuedJob item;
+        if(find_job(js, self, &item)) {
+            execute(js, self, &item);
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+typedef struct {
+    JobRangeFn fn;
+    void *data;
+    size_t begin;
+    size_t end;
+} RangeJob;
+
+static void range_job(void *data) {
+    RangeJob *rj = data;
+    rj->fn(rj->data, rj->begin, rj->end);
+}
+
+void jobs_parallel_for(JobSystem *js, size_t count, size_t grain, JobRangeFn fn, void *data) {
+    if(count == 0) return;
+
+    if(grain == 0) {
+        size_t chunks = js->threadCount*4;
+        grain = (count + chunks - 1)/chunks;
+    }
+    if((count + grain - 1)/grain > JOBS_MAX_RANGE_JOBS) {
+        grain = (count + JOBS_MAX_RANGE_JOBS - 1)/JOBS_MAX_RANGE_JOBS;
+    }
+
+    if(js->threadCount == 1 || grain >= count) {
+        fn(data, 0, count);
+        return;
+    }
+
+    RangeJob ranges[JOBS_MAX_RANGE_JOBS];
+    Job jobs[JOBS_MAX_RANGE_JOBS];
+    size_t jobCount = 0;
+
+    for(size_t begin = 0; begin < count; begin += grain) {
+        ranges[jobCount] = (RangeJob) {
+            .fn = fn,
+            .data = data,
+            .begin = begin,
+            .end = begin + grain < count ? begin + grain : count,
+        };
+        jobs[jobCount] = (Job) { .fn = range_job, .data = &ranges[jobCount] };
+        jobCount++;
+    }
+
+    JobCounter counter = {0};
+    jobs_run(js, jobs, jobCount, &counter);
+    jobs_wait(js, &counter);
+}
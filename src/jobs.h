@@ -0,0 +1,49 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define JOBS_MAX_THREADS 64
+#define JOBS_DEQUE_CAPACITY 4096 // must be a power of two
+#define JOBS_MAX_RANGE_JOBS 256 // max chunks a parallel for is split into
+
+typedef void (*JobFn)(void *data);
+typedef void (*JobRangeFn)(void *data, size_t begin, size_t end);
+
+// Counts the jobs of a batch that haven't finished yet. A job can use the
+// counter of another batch as its dependency and it won't run until it
+// reaches zero.
+typedef struct {
+    atomic_size_t pending;
+} JobCounter;
+
+typedef struct {
+    JobFn fn;
+    void *data;
+    JobCounter *dependency; // optional
+} Job;
+
+typedef struct JobSystem JobSystem;
+
+// threadCount includes the calling thread, 0 means one per cpu
+JobSystem *jobs_create(int threadCount);
+void jobs_destroy(JobSystem *js);
+int jobs_thread_count(const JobSystem *js);
+
+// 0 for the thread that created the system, 1..n-1 for the workers
+int jobs_worker_index(void);
+
+// Queues the jobs in the deque of the calling thread, the counter is
+// incremented by count and every finished job decrements it.
+void jobs_run(JobSystem *js, const Job *jobs, size_t count, JobCounter *counter);
+
+// Executes queued jobs until the counter reaches zero.
+void jobs_wait(JobSystem *js, JobCounter *counter);
+
+// Calls fn over [0, count) split in chunks of at least grain items and
+// returns when all of them are done. grain 0 picks a chunk size from the
+// number of threads.
+void jobs_parallel_for(JobSystem *js, size_t count, size_t grain, JobRangeFn fn, void *data);
+
+#endif // JOBS_H
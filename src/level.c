@@ -0,0 +1,270 @@
+#include <stdlib.h>
+
+#include "level.h"
+#include "utils.h"
+
+#define LEVEL_TOUCH 0.5f // rectangles closer than this are in the same group
+#define LEVEL_MAX_NEIGHBOURS 4096
+
+typedef struct {
+    float *items;
+    size_t count;
+    size_t capacity;
+} Floats;
+
+typedef struct {
+    float x0;
+    float x1;
+    float y; // where it started, only used by the open strips
+} Span;
+
+typedef struct {
+    Span *items;
+    size_t count;
+    size_t capacity;
+} Spans;
+
+typedef struct {
+    Rectangle *items;
+    size_t count;
+    size_t capacity;
+} Rects;
+
+static int compare_floats(const void *a, const void *b) {
+    float fa = *(const float*)a, fb = *(const float*)b;
+    return (fa > fb) - (fa < fb);
+}
+
+static int compare_spans(const void *a, const void *b) {
+    const Span *sa = a, *sb = b;
+    return (sa->x0 > sb->x0) - (sa->x0 < sb->x0);
+}
+
+static int compare_rect_tops(const void *a, const void *b) {
+    float ya = ((const Rectangle*)a)->y, yb = ((const Rectangle*)b)->y;
+    return (ya > yb) - (ya < yb);
+}
+
+static void close_strip(Colliders *out, Span strip, float y) {
+    da_append(out, ((Collider){
+        .x = strip.x0,
+        .y = strip.y,
+        .width = strip.x1 - strip.x0,
+        .height = y - strip.y,
+        .category = COLLISION_LAYER_SOLID,
+        .mask = COLLISION_LAYER_ALL,
+    }));
+}
+
+// The level is cut in horizontal bands at every top and bottom edge. Inside a
+// band the covered x intervals are merged, and a strip stays open while the
+// next band has exactly the same interval, so it grows down as far as it can.
+static void merge_bands(Colliders *out, const Rectangle *rects, size_t count) {
+    Floats edges = {0};
+    Rects sorted = {0};
+    for(size_t i = 0; i < count; i++) {
+        da_append(&edges, rects[i].y);
+        da_append(&edges, rects[i].y + rects[i].height);
+        da_append(&sorted, rects[i]);
+    }
+
+    qsort(edges.items, edges.count, sizeof(float), compare_floats);
+    size_t unique = 0;
+    for(size_t i = 0; i < edges.count; i++) {
+        if(unique == 0 || edges.items[i] != edges.items[unique - 1]) {
+            edges.items[unique++] = edges.items[i];
+        }
+    }
+    edges.count = unique;
+
+    qsort(sorted.items, sorted.count, sizeof(Rectangle), compare_rect_tops);
+
+    Rects active = {0};
+    Spans band = {0};
+    Spans open = {0};
+    Spans next = {0};
+    size_t added = 0;
+
+    for(size_t b = 0; b + 1 < edges.count; b++) {
+        float top = edges.items[b];
+
+        while(added < sorted.count && sorted.items[added].y <= top) {
+            da_append(&active, sorted.items[added]);
+            added++;
+        }
+
+        band.count = 0;
+        size_t kept = 0;
+        for(size_t k = 0; k < active.count; k++) {
+            Rectangle r = active.items[k];
+            if(r.y + r.height <= top) continue;
+
+            active.items[kept++] = r;
+            da_append(&band, ((Span){ .x0 = r.x, .x1 = r.x + r.width }));
+        }
+        active.count = kept;
+
+        qsort(band.items, band.count, sizeof(Span), compare_spans);
+        size_t merged = 0;
+        for(size_t k = 0; k < band.count; k++) {
+            if(merged > 0 && band.items[k].x0 <= band.items[merged - 1].x1) {
+                if(band.items[k].x1 > band.items[merged - 1].x1) {
+                    band.items[merged - 1].x1 = band.items[k].x1;
+                }
+            } else {
+                band.items[merged++] = band.items[k];
+            }
+        }
+        band.count = merged;
+
+        // both lists are sorted by x0 and don't overlap
+        next.count = 0;
+        size_t o = 0;
+        for(size_t k = 0; k < band.count; k++) {
+            Span span = band.items[k];
+            while(o < open.count && open.items[o].x0 < span.x0) {
+                close_strip(out, open.items[o++], top);
+            }
+
+            if(o < open.count && open.items[o].x0 == span.x0 && open.items[o].x1 == span.x1) {
+                da_append(&next, open.items[o++]);
+            } else {
+                span.y = top;
+                da_append(&next, span);
+            }
+        }
+        while(o < open.count) close_strip(out, open.items[o++], top);
+
+        Spans tmp = open;
+        open = next;
+        next = tmp;
+    }
+
+    for(size_t o = 0; o < open.count; o++) {
+        close_strip(out, open.items[o], edges.items[edges.count - 1]);
+    }
+
+    da_free(&edges);
+    da_free(&sorted);
+    da_free(&active);
+    da_free(&band);
+    da_free(&open);
+    da_free(&next);
+}
+
+static int compare_columns(const void *a, const void *b) {
+    const Collider *ca = a, *cb = b;
+    if(ca->x != cb->x) return (ca->x > cb->x) - (ca->x < cb->x);
+    if(ca->width != cb->width) return (ca->width > cb->width) - (ca->width < cb->width);
+    return (ca->y > cb->y) - (ca->y < cb->y);
+}
+
+// A strip is cut where the bands beside it change, the pieces of the same
+// column that end up touching again are joined
+static void join_columns(Colliders *out, size_t first) {
+    Collider *items = out->items + first;
+    size_t count = out->count - first;
+    qsort(items, count, sizeof(Collider), compare_columns);
+
+    size_t kept = 0;
+    for(size_t i = 0; i < count; i++) {
+        Collider *last = kept > 0 ? &items[kept - 1] : NULL;
+        if(last != NULL && last->x == items[i].x && last->width == items[i].width &&
+           last->y + last->height == items[i].y) {
+            last->height += items[i].height;
+        } else {
+            items[kept++] = items[i];
+        }
+    }
+    out->count = first + kept;
+}
+
+static uint32_t find_root(uint32_t *parent, uint32_t i) {
+    while(parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+typedef struct {
+    uint32_t group;
+    uint32_t rect;
+} GroupItem;
+
+static int compare_groups(const void *a, const void *b) {
+    const GroupItem *ga = a, *gb = b;
+    if(ga->group != gb->group) return (ga->group > gb->group) - (ga->group < gb->group);
+    return (ga->rect > gb->rect) - (ga->rect < gb->rect);
+}
+
+// The rectangles touching or overlapping each other are merged together, a
+// group the bands would cut in more pieces than it has keeps its rectangles
+void level_merge_rects(Colliders *out, const Rectangle *rects, size_t count) {
+    Rects valid = {0};
+    for(size_t i = 0; i < count; i++) {
+        if(rects[i].width > 0 && rects[i].height > 0) da_append(&valid, rects[i]);
+    }
+    if(valid.count == 0) return;
+
+    Collider *boxes = mem_alloc(MEM_TAG_SCRATCH, valid.count*sizeof(Collider));
+    uint32_t *parent = mem_alloc(MEM_TAG_SCRATCH, valid.count*sizeof(uint32_t));
+    GroupItem *items = mem_alloc(MEM_TAG_SCRATCH, valid.count*sizeof(GroupItem));
+    assert(boxes != NULL && parent != NULL && items != NULL && "No enough ram");
+    for(size_t i = 0; i < valid.count; i++) {
+        Rectangle r = valid.items[i];
+        boxes[i] = (Collider){ r.x, r.y, r.width, r.height, COLLISION_LAYER_SOLID, COLLISION_LAYER_ALL };
+        parent[i] = (uint32_t)i;
+    }
+
+    // the index only returns overlaps, so a rectangle looks a bit around it
+    // for the ones it touches
+    StaticIndex index;
+    static_index_build_in_order(&index, boxes, valid.count);
+    CollisionFilter filter = { COLLISION_LAYER_ALL, COLLISION_LAYER_ALL };
+    uint32_t found[LEVEL_MAX_NEIGHBOURS];
+    for(size_t i = 0; i < valid.count; i++) {
+        Rectangle r = valid.items[i];
+        Rectangle area = { r.x - LEVEL_TOUCH, r.y - LEVEL_TOUCH, r.width + 2*LEVEL_TOUCH, r.height + 2*LEVEL_TOUCH };
+        size_t n = static_index_query(&index, area, filter, found, LEVEL_MAX_NEIGHBOURS);
+        for(size_t k = 0; k < n; k++) {
+            uint32_t a = find_root(parent, (uint32_t)i), b = find_root(parent, index.source[found[k]]);
+            if(a != b) parent[a < b ? b : a] = a < b ? a : b;
+        }
+    }
+    static_index_free(&index);
+
+    for(size_t i = 0; i < valid.count; i++) {
+        items[i] = (GroupItem){ find_root(parent, (uint32_t)i), (uint32_t)i };
+    }
+    qsort(items, valid.count, sizeof(GroupItem), compare_groups);
+
+    Rects group = {0};
+    for(size_t i = 0; i < valid.count;) {
+        group.count = 0;
+        size_t j = i;
+        for(; j < valid.count && items[j].group == items[i].group; j++) {
+            da_append(&group, valid.items[items[j].rect]);
+        }
+        i = j;
+
+        size_t first = out->count;
+        if(group.count > 1) {
+            merge_bands(out, group.items, group.count);
+            join_columns(out, first);
+        }
+        if(group.count == 1 || out->count - first > group.count) {
+            out->count = first;
+            for(size_t k = 0; k < group.count; k++) {
+                Rectangle r = group.items[k];
+                close_strip(out, (Span){ .x0 = r.x, .x1 = r.x + r.width, .y = r.y }, r.y + r.height);
+            }
+        }
+    }
+
+    da_free(&group);
+    da_free(&valid);
+    mem_free(boxes);
+    mem_free(parent);
+    mem_free(items);
+}
@@ -0,0 +1,14 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include "raylib.h"
+#include "collision.h"
+
+// Appends to out the collision set of the rectangles: their union split in
+// as few colliders as the greedy pass finds. Rows are merged first, so a
+// floor made of abutting pieces becomes a single collider without seams.
+// Each group of rectangles touching each other is merged on its own, one
+// the bands would cut in more pieces keeps its rectangles as they are.
+void level_merge_rects(Colliders *out, const Rectangle *rects, size_t count);
+
+#endif // LEVEL_H
@@ -1,73 +1,209 @@
 #include "raylib.h"
 #include "game.h"
 #include "player.h"
+#include "tilemap.h"
+#include "origin.h"
 #include "utils.h"
+#include "mem.h"
+#include "nav.h"
+#include "generated/level_default.h"
 
-void platforms_draw(Platforms platforms) {
-    for(size_t i = 0; i < platforms.count; i++) {
-        Rectangle platform = platforms.items[i];
+// The built-in platforms stay where the level file put them, offset is where
+// the world origin is relative to the simulation
+void platforms_draw(const Rectangle *platforms, size_t count, Vector2 offset) {
+    for(size_t i = 0; i < count; i++) {
+        Rectangle platform = platforms[i];
+        platform.x += offset.x;
+        platform.y += offset.y;
         DrawRectangleLinesEx(platform, 1, BLUE);
     }
 }
 
+void moving_platforms_draw(const MovingPlatforms *mp) {
+    for(size_t i = 0; i < mp->platforms.count; i++) {
+        MovingPlatform p = mp->platforms.items[i];
+        DrawRectangleLinesEx((Rectangle){ p.pos.x, p.pos.y, p.size.x, p.size.y }, 1, SKYBLUE);
+    }
+}
+
+void tilemap_draw(const Tilemap *map) {
+    for(int row = 0; row < map->rows; row++) {
+        for(int col = 0; col < map->cols; col++) {
+            if(!tilemap_get(map, col, row)) continue;
+
+            Rectangle tile = {
+                .x = map->originX + col*map->tileSize,
+                .y = map->originY + row*map->tileSize,
+                .width = map->tileSize,
+                .height = map->tileSize,
+            };
+            DrawRectangleLinesEx(tile, 1, GREEN);
+        }
+    }
+}
+
+void triggers_draw(const TriggerSet *set) {
+    for(size_t i = 0; i < set->triggers.count; i++) {
+        Trigger t = set->triggers.items[i];
+        Rectangle rec = { t.volume.x, t.volume.y, t.volume.width, t.volume.height };
+        DrawRectangleLinesEx(rec, 1, t.kind == TRIGGER_HAZARD ? ORANGE : YELLOW);
+    }
+}
+
+// F4, the spans in green and the links colored by type
+void nav_draw(const NavGraph *nav, Vector2 offset) {
+    static const Color LINK_COLORS[] = { GREEN, GRAY, YELLOW, SKYBLUE };
+
+    for(size_t i = 0; i < nav->linkCount; i++) {
+        NavLink link = nav->links[i];
+        Vector2 from = { link.fromX + offset.x, nav->spans[link.from].y + offset.y };
+        Vector2 to = { link.toX + offset.x, nav->spans[link.to].y + offset.y };
+        DrawLineV(from, to, Fade(LINK_COLORS[link.type], 0.5f));
+    }
+    for(size_t i = 0; i < nav->spanCount; i++) {
+        NavSpan span = nav->spans[i];
+        DrawLineEx((Vector2){ span.x0 + offset.x, span.y + offset.y - 2 },
+                   (Vector2){ span.x1 + offset.x, span.y + offset.y - 2 }, 3, LIME);
+    }
+}
+
+// F3, one line per tag, red once a tag refused an allocation
+void memory_overlay_draw(void) {
+    DrawRectangle(5, 5, 560, 10 + 20*MEM_TAG_COUNT, Fade(BLACK, 0.7f));
+    for(int t = 0; t < MEM_TAG_COUNT; t++) {
+        MemStats stats = mem_stats(t);
+        const char *text = TextFormat("%-9s %8.1f KB  peak %8.1f KB  %6zu allocs", mem_tag_name(t),
+                                      stats.live/1024.0f, stats.peak/1024.0f, stats.allocations);
+        if(stats.budget > 0) text = TextFormat("%s / %.0f KB", text, stats.budget/1024.0f);
+        DrawText(text, 10, 10 + 20*t, 20, stats.failures > 0 ? RED : WHITE);
+    }
+}
+
+void respawn_player(Game *game) {
+    game->player = (Player) {
+        .pos = game->spawn,
+        .dir = PLAYER_DIR_RIGHT,
+        .riding = COLLIDER_REF_NONE,
+    };
+}
+
+static const ParticleEmitter IMPACT_SPARKS = {
+    .velocitySpread = { 120, 120 },
+    .life = 0.2f,
+    .lifeSpread = 0.05f,
+    .size = 3,
+    .color = ORANGE,
+};
+
+void handle_projectile_hits(Game *game) {
+    Projectiles *p = &game->projectiles;
+
+    bool playerHit = false;
+    for(size_t i = 0; i < p->hitCount; i++) {
+        ProjectileHit hit = p->hits[i];
+        if(hit.type == PROJECTILE_HIT_PLAYER) playerHit = true;
+        else particles_emit(&game->particles, &IMPACT_SPARKS, hit.pos, 4);
+    }
+    if(playerHit) respawn_player(game);
+}
+
+void handle_trigger_events(Game *game) {
+    TriggerSet *set = &game->triggers;
+
+    for(size_t i = 0; i < set->eventCount; i++) {
+        TriggerEvent event = set->events[i];
+        if(event.type != TRIGGER_ENTER) continue;
+
+        Trigger t = set->triggers.items[event.trigger];
+        switch(t.kind) {
+            case TRIGGER_CHECKPOINT:
+                game->spawn = (Vector2){ t.volume.x, t.volume.y };
+                break;
+            case TRIGGER_HAZARD:
+                respawn_player(game);
+                break;
+            case TRIGGER_ROOM:
+                break;
+        }
+    }
+}
+
 int main(void) {
     InitWindow(1280, 720, "C Game");
     SetTargetFPS(60);
 
+    // the default level peaks under 1 MB in every tag, see the F3 overlay.
+    // Going over the level, physics or scratch ones aborts, see mem.h
+    mem_set_budget(MEM_TAG_LEVEL, 4 << 20);
+    mem_set_budget(MEM_TAG_PHYSICS, 8 << 20);
+    mem_set_budget(MEM_TAG_RENDER, 4 << 20);
+    mem_set_budget(MEM_TAG_STREAMING, 4 << 20);
+    mem_set_budget(MEM_TAG_SCRATCH, 4 << 20);
+
     Game game = {
         .camera = {
             .zoom = 1,
         },
         .player = {
             .dir = 1,
+            .riding = COLLIDER_REF_NONE,
         },
     };
 
-    da_append(&game.platforms, ((Rectangle){
-        .x = 1200,
-        .y = -120,
-        .width = 80,
-        .height = 850,
-    }));
-
-    da_append(&game.platforms, ((Rectangle){
-        .x = 0,
-        .y = 680,
-        .width = 1200,
-        .height = 40,
-    }));
-
-    da_append(&game.platforms, ((Rectangle){
-        .x = 350,
-        .y = 450,
-        .width = 200,
-        .height = 80,
-    }));
-
-
-    da_append(&game.platforms, ((Rectangle){
-        .x = 800,
-        .y = 200,
-        .width = 200,
-        .height = 80,
-    }));
-
-    da_append(&game.platforms, ((Rectangle){
-        .x = 600,
-        .y = 500,
-        .width = 10,
-        .height = 220,
-    }));
-
-    for(size_t i = 0; i < game.platforms.count; i++) {
-        Rectangle p = game.platforms.items[i];
-        da_append(&game.colliders, ((Collider){
-            .x = p.x,
-            .y = p.y,
-            .width = p.width,
-            .height = p.height,
-        }));
+    // the platforms are in the binary already merged and indexed, see
+    // levels/default.lvl. The index copies them the first time it's shifted.
+    collision_world_from_index(&game.collision, level_default_index);
+    TraceLog(LOG_INFO, "LEVEL: %d platforms merged into %zu colliders", LEVEL_DEFAULT_PLATFORM_COUNT,
+             level_default_index.count);
+
+    // where enemies can go on the built-in platforms, the tiles and the
+    // elevator aren't part of it
+    Collider *levelColliders = mem_alloc(MEM_TAG_SCRATCH, level_default_index.count*sizeof(Collider));
+    for(uint32_t i = 0; i < level_default_index.count; i++) {
+        levelColliders[i] = static_index_get(&level_default_index, i);
     }
+    NavGraph nav;
+    nav_build(&nav, levelColliders, level_default_index.count);
+    mem_free(levelColliders);
+    TraceLog(LOG_INFO, "NAV: %zu spans, %zu links", nav.spanCount, nav.linkCount);
+
+    tilemap_load_string(&game.tiles,
+        "#.....\n"
+        "##....\n"
+        "###...\n",
+        40, (Vector2){ 0, 560 });
+    game.collision.tiles = &game.tiles;
+
+    // an elevator between the floor and the top of the wall
+    Vector2 elevator[] = { { 1030, 540 }, { 1030, 120 } };
+    moving_platforms_add(&game.moving, &game.collision, elevator, 2, (Vector2){ 150, 20 }, 150);
+
+    trigger_set_add(&game.triggers, (Rectangle){ 0, 0, 200, 200 }, TRIGGER_CHECKPOINT);
+    trigger_set_add(&game.triggers, (Rectangle){ 800, 40, 200, 160 }, TRIGGER_CHECKPOINT);
+    // anything falling off the left side of the level
+    trigger_set_add(&game.triggers, (Rectangle){ -5000, 1500, 10000, 500 }, TRIGGER_HAZARD);
+    trigger_set_build(&game.triggers);
+
+    game.jobs = jobs_create(0);
+
+    // dash trails and landing dust, see player_update
+    particles_init(&game.particles, 16384, 600, 3);
+
+    // a turret spraying a spiral over the left side of the level
+    projectiles_init(&game.projectiles, 20000);
+    ProjectileEmitter turret = {
+        .pos = { 150, 100 },
+        .rate = 4,
+        .arms = 5,
+        .spin = 1.2f,
+        .speed = 250,
+        .life = 6,
+        .radius = 6,
+    };
+    PoolHandle turretHandle = projectiles_add_emitter(&game.projectiles, turret);
+
+    bool showMemory = false;
+    bool showNav = false;
 
     while(!WindowShouldClose()) {
         BeginDrawing();
@@ -82,13 +218,53 @@ int main(void) {
         }
 
         BeginMode2D(game.camera);
+        origin_rebase(&game);
+        collision_world_begin_tick(&game.collision);
+        moving_platforms_update(&game.moving, &game.collision, GetFrameTime());
         player_update(&game);
-        platforms_draw(game.platforms);
+        projectiles_update_parallel(game.jobs, &game.projectiles, &game.collision, player_get_rec(&game.player), GetFrameTime());
+        handle_projectile_hits(&game);
+        particles_update_parallel(game.jobs, &game.particles, GetFrameTime());
+
+        triggers_begin_tick(&game.triggers);
+        CollisionFilter playerTriggerFilter = { COLLISION_LAYER_PLAYER, COLLISION_LAYER_TRIGGER };
+        triggers_track(&game.triggers, &game.playerTriggers, player_get_rec(&game.player), playerTriggerFilter, 0);
+        handle_trigger_events(&game);
+
+        Vector2 worldOffset = { -(float)game.originX, -(float)game.originY };
+        platforms_draw(level_default_platforms, LEVEL_DEFAULT_PLATFORM_COUNT, worldOffset);
+        moving_platforms_draw(&game.moving);
+        tilemap_draw(&game.tiles);
+        triggers_draw(&game.triggers);
+        particles_draw(&game.particles);
+        projectiles_draw(&game.projectiles);
+        if(showNav) nav_draw(&nav, worldOffset);
         EndMode2D();
 
+        if(IsKeyPressed(KEY_F3)) showMemory = !showMemory;
+        if(showMemory) memory_overlay_draw();
+        if(IsKeyPressed(KEY_F4)) showNav = !showNav;
+        // switching it back on spawns a new one, the old handle is stale
+        if(IsKeyPressed(KEY_F5)) {
+            if(projectiles_remove_emitter(&game.projectiles, turretHandle)) {
+                turretHandle = POOL_HANDLE_NONE;
+            } else {
+                turretHandle = projectiles_add_emitter(&game.projectiles, turret);
+            }
+        }
+
         EndDrawing();
     }
 
+    nav_free(&nav);
+    moving_platforms_free(&game.moving);
+    particles_free(&game.particles);
+    projectiles_free(&game.projectiles);
+    jobs_destroy(game.jobs);
+    collision_world_free(&game.collision);
+    tilemap_free(&game.tiles);
+    trigger_set_free(&game.triggers);
+
     CloseWindow();
     return 0;
 }
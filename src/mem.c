@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <assert.h>
+
+#include "mem.h"
+
+#define MEM_MAGIC 0x6d656d21u
+
+// In front of every block, 16 bytes so the block keeps the alignment of malloc
+typedef struct {
+    size_t size;
+    uint32_t tag;
+    uint32_t magic;
+} MemHeader;
+
+typedef struct {
+    atomic_size_t live;
+    atomic_size_t peak;
+    atomic_size_t allocations;
+    atomic_size_t failures;
+    atomic_size_t budget;
+} MemCounters;
+
+static MemCounters counters[MEM_TAG_COUNT];
+
+static const char *tagNames[MEM_TAG_COUNT] = {
+    [MEM_TAG_LEVEL] = "level",
+    [MEM_TAG_PHYSICS] = "physics",
+    [MEM_TAG_RENDER] = "render",
+    [MEM_TAG_STREAMING] = "streaming",
+    [MEM_TAG_SCRATCH] = "scratch",
+};
+
+// Counts size in tag unless it goes over the budget. The add comes first, so
+// two threads can't both squeeze under the budget.
+static bool reserve(MemTag tag, size_t size) {
+    MemCounters *c = &counters[tag];
+    size_t live = atomic_fetch_add(&c->live, size) + size;
+    size_t budget = atomic_load(&c->budget);
+    if(budget != 0 && live > budget) {
+        atomic_fetch_sub(&c->live, size);
+        // the tags that cope with it may be refused every tick, the first
+        // one is enough to know
+        if(atomic_fetch_add(&c->failures, 1) == 0) {
+            fprintf(stderr, "mem: %s over its budget of %zu bytes\n", tagNames[tag], budget);
+        }
+        return false;
+    }
+
+    size_t peak = atomic_load(&c->peak);
+    while(live > peak && !atomic_compare_exchange_weak(&c->peak, &peak, live)) {}
+    atomic_fetch_add(&c->allocations, 1);
+    return true;
+}
+
+static void release(MemTag tag, size_t size) {
+    atomic_fetch_sub(&counters[tag].live, size);
+}
+
+static MemHeader *header_of(void *ptr) {
+    MemHeader *h = (MemHeader*)ptr - 1;
+    assert(h->magic == MEM_MAGIC && "Not allocated by mem_alloc");
+    return h;
+}
+
+void *mem_alloc(MemTag tag, size_t size) {
+    assert(tag < MEM_TAG_COUNT);
+    if(size > SIZE_MAX - sizeof(MemHeader)) return NULL;
+    if(!reserve(tag, size)) return NULL;
+
+    MemHeader *h = malloc(sizeof(MemHeader) + size);
+    if(h == NULL) {
+        release(tag, size);
+        return NULL;
+    }
+
+    *h = (MemHeader) {
+        .size = size,
+        .tag = tag,
+        .magic = MEM_MAGIC,
+    };
+    return h + 1;
+}
+
+void *mem_calloc(MemTag tag, size_t count, size_t size) {
+    if(size != 0 && count > SIZE_MAX/size) return NULL;
+
+    void *ptr = mem_alloc(tag, count*size);
+    if(ptr != NULL) memset(ptr, 0, count*size);
+    return ptr;
+}
+
+void *mem_realloc(MemTag tag, void *ptr, size_t size) {
+    if(ptr == NULL) return mem_alloc(tag, size);
+    assert(tag < MEM_TAG_COUNT);
+    if(size > SIZE_MAX - sizeof(MemHeader)) return NULL;
+
+    MemHeader *h = header_of(ptr);
+    MemTag oldTag = h->tag;
+    size_t oldSize = h->size;
+
+    // on failure the old block is left as it was, counted where it was
+    release(oldTag, oldSize);
+    if(!reserve(tag, size)) {
+        atomic_fetch_add(&counters[oldTag].live, oldSize);
+        return NULL;
+    }
+
+    MemHeader *moved = realloc(h, sizeof(MemHeader) + size);
+    if(moved == NULL) {
+        release(tag, size);
+        atomic_fetch_add(&counters[oldTag].live, oldSize);
+        return NULL;
+    }
+
+    moved->size = size;
+    moved->tag = tag;
+    return moved + 1;
+}
+
+void mem_free(void *ptr) {
+    if(ptr == NULL) return;
+
+    MemHeader *h = header_of(ptr);
+    release(h->tag, h->size);
+    h->magic = 0;
+    free(h);
+}
+
+void mem_set_budget(MemTag tag, size_t bytes) {
+    assert(tag < MEM_TAG_COUNT);
+    atomic_store(&counters[tag].budget, bytes);
+}
+
+MemStats mem_stats(MemTag tag) {
+    assert(tag < MEM_TAG_COUNT);
+    MemCounters *c = &counters[tag];
+    return (MemStats) {
+        .live = atomic_load(&c->live),
+        .peak = atomic_load(&c->peak),
+        .allocations = atomic_load(&c->allocations),
+        .failures = atomic_load(&c->failures),
+        .budget = atomic_load(&c->budget),
+    };
+}
+
+const char *mem_tag_name(MemTag tag) {
+    assert(tag < MEM_TAG_COUNT);
+    return tagNames[tag];
+}
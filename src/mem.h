@@ -0,0 +1,45 @@
+#ifndef MEM_H
+#define MEM_H
+
+#include <stddef.h>
+
+// What an allocation is for. Every heap allocation of the game goes through
+// mem_* with one of them, so the live and peak bytes of each subsystem are
+// known and can be capped.
+typedef enum {
+    MEM_TAG_LEVEL, // static colliders, their index, tiles
+    MEM_TAG_PHYSICS, // dynamic colliders, broadphase, triggers, simulation
+    MEM_TAG_RENDER,
+    MEM_TAG_STREAMING,
+    MEM_TAG_SCRATCH, // temporaries freed before the function returns
+    MEM_TAG_COUNT,
+} MemTag;
+
+typedef struct {
+    size_t live; // bytes
+    size_t peak;
+    size_t allocations; // allocs and reallocs that got memory
+    size_t failures; // refused because of the budget
+    size_t budget; // 0 when there's none
+} MemStats;
+
+// Same as malloc, calloc and realloc with the bytes counted in tag. An
+// allocation that would take tag over its budget fails like the system ran
+// out of memory and is counted in failures. mem_realloc moves the block to
+// tag. The blocks can only be freed by mem_free.
+//
+// Only render and streaming cope with a refusal: the particles go without
+// effects and a running stream asks for the chunk again on the next tick.
+// The others assert like they do when malloc fails, so their budget is a
+// hard cap that aborts the game.
+void *mem_alloc(MemTag tag, size_t size);
+void *mem_calloc(MemTag tag, size_t count, size_t size);
+void *mem_realloc(MemTag tag, void *ptr, size_t size);
+void mem_free(void *ptr);
+
+// Thread safe, the counters are atomic
+void mem_set_budget(MemTag tag, size_t bytes);
+MemStats mem_stats(MemTag tag);
+const char *mem_tag_name(MemTag tag);
+
+#endif // MEM_H
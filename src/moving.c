@@ -0,0 +1,84 @@
+#include <math.h>
+
+#include "moving.h"
+#define DA_MEM_TAG MEM_TAG_PHYSICS
+#include "utils.h"
+
+void moving_platforms_add(MovingPlatforms *mp, CollisionWorld *world, const Vector2 *path, size_t count,
+                          Vector2 size, float speed) {
+    assert(count > 0);
+
+    MovingPlatform platform = {
+        .pos = path[0],
+        .size = size,
+        .speed = speed,
+        .pathStart = mp->points.count,
+        .pathCount = count,
+        .target = count > 1 ? 1 : 0,
+    };
+    for(size_t i = 0; i < count; i++) da_append(&mp->points, path[i]);
+
+    platform.ref = collision_world_add_dynamic(world, (Collider) {
+        .x = platform.pos.x,
+        .y = platform.pos.y,
+        .width = size.x,
+        .height = size.y,
+        .category = COLLISION_LAYER_SOLID,
+        .mask = COLLISION_LAYER_ALL,
+    });
+    da_append(&mp->platforms, platform);
+}
+
+void moving_platforms_free(MovingPlatforms *mp) {
+    da_free(&mp->platforms);
+    da_free(&mp->points);
+    *mp = (MovingPlatforms){0};
+}
+
+void moving_platforms_shift(MovingPlatforms *mp, Vector2 delta) {
+    for(size_t i = 0; i < mp->platforms.count; i++) {
+        mp->platforms.items[i].pos.x += delta.x;
+        mp->platforms.items[i].pos.y += delta.y;
+    }
+    for(size_t i = 0; i < mp->points.count; i++) {
+        mp->points.items[i].x += delta.x;
+        mp->points.items[i].y += delta.y;
+    }
+}
+
+void moving_platforms_update(MovingPlatforms *mp, CollisionWorld *world, float dt) {
+    for(size_t i = 0; i < mp->platforms.count; i++) {
+        MovingPlatform *p = &mp->platforms.items[i];
+        if(p->pathCount < 2 || p->speed <= 0) continue;
+
+        // the distance left is carried to the next point, so fast platforms
+        // don't slow down at the corners. At most one lap per tick, which also
+        // stops paths where every point is the same.
+        float travel = p->speed*dt;
+        for(uint32_t hops = 0; travel > 0 && hops <= p->pathCount; hops++) {
+            Vector2 target = mp->points.items[p->pathStart + p->target];
+            float dx = target.x - p->pos.x;
+            float dy = target.y - p->pos.y;
+            float dist = sqrtf(dx*dx + dy*dy);
+
+            if(dist > travel) {
+                p->pos.x += dx/dist*travel;
+                p->pos.y += dy/dist*travel;
+                break;
+            }
+
+            p->pos = target;
+            travel -= dist;
+            p->target = (p->target + 1) % p->pathCount;
+        }
+
+        collision_world_set_dynamic(world, p->ref, (Collider) {
+            .x = p->pos.x,
+            .y = p->pos.y,
+            .width = p->size.x,
+            .height = p->size.y,
+            .category = COLLISION_LAYER_SOLID,
+            .mask = COLLISION_LAYER_ALL,
+        });
+    }
+}
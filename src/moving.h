@@ -0,0 +1,49 @@
+#ifndef MOVING_H
+#define MOVING_H
+
+#include <stdint.h>
+#include "raylib.h"
+#include "collision.h"
+
+// A kinematic platform going through the points of its path in a loop, a path
+// of two points goes back and forth. Its collider lives in the dynamic index.
+typedef struct {
+    ColliderRef ref;
+    Vector2 pos;
+    Vector2 size;
+    float speed;
+
+    uint32_t pathStart; // first point in MovingPlatforms.points
+    uint32_t pathCount;
+    uint32_t target; // point it is heading to, relative to pathStart
+} MovingPlatform;
+
+typedef struct {
+    MovingPlatform *items;
+    size_t count;
+    size_t capacity;
+} MovingPlatformList;
+
+typedef struct {
+    Vector2 *items;
+    size_t count;
+    size_t capacity;
+} PathPoints;
+
+typedef struct {
+    MovingPlatformList platforms;
+    PathPoints points;
+} MovingPlatforms;
+
+// The platform starts at path[0], the path is copied
+void moving_platforms_add(MovingPlatforms *mp, CollisionWorld *world, const Vector2 *path, size_t count,
+                          Vector2 size, float speed);
+void moving_platforms_free(MovingPlatforms *mp);
+// Moves the platforms and their paths, their colliders are shifted with the world
+void moving_platforms_shift(MovingPlatforms *mp, Vector2 delta);
+
+// Moves every platform along its path and updates its collider, call it after
+// collision_world_begin_tick and before the bodies that can ride them
+void moving_platforms_update(MovingPlatforms *mp, CollisionWorld *world, float dt);
+
+#endif // MOVING_H
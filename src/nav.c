@@ -0,0 +1,589 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "nav.h"
+#define DA_MEM_TAG MEM_TAG_PHYSICS
+#include "utils.h"
+
+#define NAV_MAX_BLOCKERS 64 // colliders cutting the top of a single collider
+#define NAV_MAX_HITS 16 // colliders the player touches in a tick
+#define NAV_MAX_CANDIDATES 256 // spans returned by a lookup
+#define NAV_MAX_LAUNCHES 32 // points of a span the links are flown from
+#define NAV_LAUNCH_MERGE 16 // launch points closer than that are the same
+#define NAV_START_SLACK 1.0f // how far from fromX a link is replayed from too
+
+#define ARRAY_LEN(a) (sizeof(a)/sizeof((a)[0]))
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+// How high a jump held to the end takes the feet: pushed up by the jump
+// force minus gravity for the jump duration, then slowed down by gravity
+#define NAV_JUMP_SPEED ((PLAYER_JUMP_FORCE - PLAYER_GRAVITY)*PLAYER_JUMP_DURATION)
+#define NAV_JUMP_HEIGHT (0.5f*NAV_JUMP_SPEED*PLAYER_JUMP_DURATION + NAV_JUMP_SPEED*NAV_JUMP_SPEED/(2.0f*PLAYER_GRAVITY))
+
+#define NAV_FULL_JUMP ((int)(PLAYER_JUMP_DURATION/NAV_DT) + 1)
+#define NAV_HOP 6
+#define NAV_APEX ((int)((PLAYER_JUMP_DURATION + NAV_JUMP_SPEED/PLAYER_GRAVITY)/NAV_DT))
+
+static const CollisionFilter NAV_FILTER = {
+    .category = COLLISION_LAYER_PLAYER,
+    .mask = COLLISION_LAYER_SOLID,
+};
+
+typedef struct {
+    NavSpan *items;
+    size_t count;
+    size_t capacity;
+} NavSpans;
+
+typedef struct {
+    NavLink *items;
+    size_t count;
+    size_t capacity;
+} NavLinks;
+
+// Inputs flown from every launch point toward both sides, speed is the one
+// at the start as a fraction of the max and the side is held from the tick
+// holdFrom to holdTo
+typedef struct {
+    float speed;
+    int holdFrom;
+    int holdTo;
+    int jumpTicks;
+    int dashTick;
+} NavMove;
+
+// only from the ends that can be walked off
+static const NavMove WALK_OFF[] = {
+    { 1, 0, NAV_MAX_TICKS, 0, -1 },
+    { 1, 0, 0, 0, -1 },
+};
+
+static const NavMove TAKE_OFF[] = {
+    // jumps, letting go of the side at some point to stop over something
+    // narrow or only pushing once high enough to clear the edge of a ledge
+    { 0, 0, 0, NAV_FULL_JUMP, -1 },
+    { 0, 0, NAV_MAX_TICKS, NAV_FULL_JUMP, -1 },
+    { 0, 0, NAV_FULL_JUMP/2, NAV_FULL_JUMP, -1 },
+    { 0, 0, NAV_FULL_JUMP, NAV_FULL_JUMP, -1 },
+    { 0, 0, (NAV_FULL_JUMP + NAV_APEX)/2, NAV_FULL_JUMP, -1 },
+    { 0, 0, NAV_APEX, NAV_FULL_JUMP, -1 },
+    { 0, NAV_FULL_JUMP/2, NAV_MAX_TICKS, NAV_FULL_JUMP, -1 },
+    { 0, NAV_FULL_JUMP, NAV_MAX_TICKS, NAV_FULL_JUMP, -1 },
+    { 1, 0, NAV_MAX_TICKS, NAV_FULL_JUMP, -1 },
+    { 1, 0, NAV_FULL_JUMP/2, NAV_FULL_JUMP, -1 },
+    { 1, 0, 0, NAV_FULL_JUMP, -1 },
+    { 0, 0, NAV_MAX_TICKS, NAV_HOP, -1 },
+    { 1, 0, NAV_MAX_TICKS, NAV_HOP, -1 },
+    // dashes from the ground, at the end of the jump push and at the apex
+    { 0, 0, NAV_MAX_TICKS, 0, 0 },
+    { 1, 0, NAV_MAX_TICKS, 0, 0 },
+    { 0, 0, NAV_MAX_TICKS, NAV_FULL_JUMP, NAV_FULL_JUMP },
+    { 1, 0, NAV_MAX_TICKS, NAV_FULL_JUMP, NAV_FULL_JUMP },
+    { 1, 0, NAV_MAX_TICKS, NAV_FULL_JUMP, NAV_APEX },
+};
+
+// how far beside a span above the jumps to it start, in player widths
+static const float LAUNCH_DISTANCES[] = { 1, 2, 3, 4, 6, 8 };
+
+static void *alloc_array(size_t count, size_t size) {
+    void *ptr = mem_alloc(MEM_TAG_PHYSICS, (count > 0 ? count : 1)*size);
+    assert(ptr != NULL && "No enough ram");
+    return ptr;
+}
+
+typedef struct {
+    float x0;
+    float x1;
+} Interval;
+
+static int compare_intervals(const void *a, const void *b) {
+    float x = ((const Interval*)a)->x0, y = ((const Interval*)b)->x0;
+    return (x > y) - (x < y);
+}
+
+// The top of a collider minus where something above leaves no room for the
+// player, each blocker rules out the centers that would put the player in it
+static void add_spans(NavSpans *spans, const StaticIndex *solids, Collider c) {
+    float half = PLAYER_WIDTH/2.0f;
+    float right = c.x + c.width;
+    Rectangle band = { c.x - half, c.y - PLAYER_HEIGHT, c.width + PLAYER_WIDTH, PLAYER_HEIGHT };
+
+    Collider blockers[NAV_MAX_BLOCKERS];
+    size_t count = static_index_query_colliders(solids, band, NAV_FILTER, blockers, NAV_MAX_BLOCKERS);
+
+    Interval cuts[NAV_MAX_BLOCKERS];
+    for(size_t i = 0; i < count; i++) {
+        cuts[i] = (Interval){ blockers[i].x - half, blockers[i].x + blockers[i].width + half };
+    }
+    qsort(cuts, count, sizeof(*cuts), compare_intervals);
+
+    float x = c.x;
+    bool cutLeft = false;
+    for(size_t i = 0; i <= count; i++) {
+        bool last = i == count;
+        float end = last ? right : fminf(cuts[i].x0, right);
+        if(end - x >= 1) {
+            da_append(spans, ((NavSpan){
+                .x0 = x,
+                .x1 = end,
+                .y = c.y,
+                .openLeft = !cutLeft,
+                .openRight = last || cuts[i].x0 >= right,
+            }));
+        }
+        if(last) break;
+        if(cuts[i].x1 > x) {
+            x = cuts[i].x1;
+            cutLeft = true;
+        }
+    }
+}
+
+Player nav_link_start(const NavGraph *nav, const NavLink *link) {
+    const NavSpan *span = &nav->spans[link->from];
+    int dir = link->hold != 0 ? link->hold : (link->startSpeed < 0 ? PLAYER_DIR_LEFT : PLAYER_DIR_RIGHT);
+
+    return (Player) {
+        .pos = { link->fromX - PLAYER_WIDTH/2.0f, span->y - PLAYER_HEIGHT },
+        .vel = { link->startSpeed, 0 },
+        .isOnFloor = true,
+        .riding = COLLIDER_REF_NONE,
+        .dir = dir,
+    };
+}
+
+PlayerInput nav_link_input(const NavLink *link, int tick) {
+    return (PlayerInput) {
+        .left = link->hold < 0 && tick >= link->holdFrom && tick < link->holdTo,
+        .right = link->hold > 0 && tick >= link->holdFrom && tick < link->holdTo,
+        .jumpPressed = link->jumpTicks > 0 && tick == 0,
+        .jumpReleased = link->jumpTicks > 0 && tick == link->jumpTicks,
+        .dashPressed = tick == link->dashTick,
+    };
+}
+
+uint32_t nav_locate(const NavGraph *nav, Vector2 feet, float maxDrop) {
+    Rectangle area = { feet.x - 0.5f, feet.y - 0.5f, 1, maxDrop + 1 };
+    uint32_t found[NAV_MAX_CANDIDATES];
+    size_t count = static_index_query(&nav->lookup, area, NAV_FILTER, found, NAV_MAX_CANDIDATES);
+
+    // the highest, then the one whose range is the closest
+    uint32_t best = NAV_NONE;
+    float bestY = INFINITY, bestDistance = INFINITY;
+    for(size_t i = 0; i < count; i++) {
+        uint32_t s = nav->lookup.source[found[i]];
+        NavSpan span = nav->spans[s];
+        float distance = fmaxf(fmaxf(span.x0 - feet.x, feet.x - span.x1), 0);
+        if(span.y < bestY || (span.y == bestY && distance < bestDistance)) {
+            best = s;
+            bestY = span.y;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+// The tick after t where the inputs of the link change, either a press or
+// the side being held or let go
+static int next_input_change(const NavLink *link, int t) {
+    int changes[] = { 1, link->holdFrom, link->holdTo, link->jumpTicks, link->jumpTicks + 1, link->dashTick,
+                      link->dashTick + 1 };
+    int next = NAV_MAX_TICKS;
+    for(size_t i = 0; i < ARRAY_LEN(changes); i++) {
+        if(changes[i] > t) next = MIN(next, changes[i]);
+    }
+    return next;
+}
+
+// Follows a link from its start until the player lands after leaving the
+// ground. Between two changes of the inputs the flight is a single arc, only
+// the ticks on the ground are stepped since the floor holds the player up.
+// Bumping into anything on the way, stopping on the ground, falling below
+// the level or flying for too long fail it.
+static bool fly(const NavGraph *nav, NavLink *link) {
+    Player p = nav_link_start(nav, link);
+    bool airborne = false;
+
+    for(int t = 0; t < NAV_MAX_TICKS;) {
+        PlayerArc arc;
+        player_arc(&p, nav_link_input(link, t), NAV_DT, next_input_change(link, t) - t, &arc);
+        if(arc.ticks == 0) return false;
+
+        PlayerArcHit hit;
+        if(!player_arc_hit(&arc, &nav->solids, &hit)) {
+            airborne = true;
+            p = arc.end;
+            t += arc.ticks;
+            if(p.pos.y + PLAYER_HEIGHT > nav->bottom) return false;
+            continue;
+        }
+        if(hit.type != PLAYER_ARC_LAND) return false;
+
+        if(airborne || hit.tick > 1) {
+            Vector2 feet = { hit.pos.x + PLAYER_WIDTH/2.0f, hit.collider.y };
+            link->to = nav_locate(nav, feet, 1);
+            link->toX = feet.x;
+            link->ticks = t + hit.tick;
+            return link->to != NAV_NONE;
+        }
+
+        // still walking to the end of the span
+        player_step_free(&p, nav_link_input(link, t), NAV_DT);
+        p.pos.y = hit.pos.y;
+        p.vel.y = 0;
+        p.isOnFloor = true;
+        if(p.vel.x == 0 && !p.dashing) return false;
+        t++;
+    }
+    return false;
+}
+
+// The arcs don't round like the ticks summed one by one, so a landing right
+// on the edge of a collider can go the other way when stepped. An agent
+// doesn't stop exactly on fromX either, so the link is only kept when
+// player_step ends on its span from a bit to either side as well.
+static bool replay(const NavGraph *nav, const NavLink *link) {
+    for(int side = -1; side <= 1; side++) {
+        Player p = nav_link_start(nav, link);
+        p.pos.x += side*NAV_START_SLACK;
+        for(int t = 0; t < link->ticks; t++) player_step(&p, &nav->solids, nav_link_input(link, t), NAV_DT);
+
+        Vector2 feet = { p.pos.x + PLAYER_WIDTH/2.0f, p.pos.y + PLAYER_HEIGHT };
+        if(!p.isOnFloor || nav_locate(nav, feet, 1) != link->to) return false;
+    }
+    return true;
+}
+
+static NavLinkType link_type(const NavLink *link) {
+    if(link->dashTick >= 0) return NAV_LINK_DASH;
+    if(link->jumpTicks > 0) return NAV_LINK_JUMP;
+    return NAV_LINK_FALL;
+}
+
+// Only the quickest link of each type between two spans is kept, the links
+// of the span being built start at first. Stepping is the slow part, so an
+// air link is only replayed once it would be kept.
+static void add_link(const NavGraph *nav, NavLinks *links, size_t first, NavLink link) {
+    if(link.to == link.from) return;
+
+    NavLink *same = NULL;
+    for(size_t i = first; i < links->count; i++) {
+        if(links->items[i].to == link.to && links->items[i].type == link.type) {
+            same = &links->items[i];
+            break;
+        }
+    }
+    if(same != NULL && same->ticks <= link.ticks) return;
+    if(link.type != NAV_LINK_WALK && !replay(nav, &link)) return;
+
+    if(same != NULL) *same = link;
+    else da_append(links, link);
+}
+
+// A span at the same height starting where this one ends, the level goes on
+// there without a gap
+static void add_walk_links(NavGraph *nav, NavLinks *links, uint32_t s, size_t first) {
+    NavSpan span = nav->spans[s];
+
+    for(int dir = -1; dir <= 1; dir += 2) {
+        float end = dir < 0 ? span.x0 : span.x1;
+        uint32_t found[NAV_MAX_CANDIDATES];
+        size_t count = static_index_query(&nav->lookup, (Rectangle){ end - 0.5f, span.y - 0.5f, 1, 1 }, NAV_FILTER,
+                                          found, NAV_MAX_CANDIDATES);
+
+        for(size_t i = 0; i < count; i++) {
+            uint32_t other = nav->lookup.source[found[i]];
+            NavSpan next = nav->spans[other];
+            if(other == s || next.y != span.y) continue;
+
+            bool touching = dir < 0 ? next.x1 >= end - 0.5f && next.x0 < end : next.x0 <= end + 0.5f && next.x1 > end;
+            if(!touching) continue;
+
+            float to = dir < 0 ? fminf(next.x1, end) : fmaxf(next.x0, end);
+            add_link(nav, links, first, (NavLink){
+                .from = s,
+                .to = other,
+                .type = NAV_LINK_WALK,
+                .fromX = end,
+                .toX = to,
+                .startSpeed = dir*PLAYER_MAX_HORIZONTAL_VELOCITY,
+                .hold = dir,
+                .holdTo = NAV_MAX_TICKS,
+                .dashTick = -1,
+                .ticks = (int)ceilf(fabsf(to - end)/PLAYER_MAX_HORIZONTAL_VELOCITY/NAV_DT),
+            });
+        }
+    }
+}
+
+static void add_launch(float *launches, size_t *count, NavSpan span, float x) {
+    x = fminf(fmaxf(x, span.x0), span.x1);
+    if(*count == NAV_MAX_LAUNCHES) return;
+    for(size_t i = 0; i < *count; i++) {
+        if(fabsf(launches[i] - x) < NAV_LAUNCH_MERGE) return;
+    }
+    launches[(*count)++] = x;
+}
+
+static void fly_move(NavGraph *nav, NavLinks *links, size_t first, uint32_t s, float x, int dir, NavMove move) {
+    NavLink link = {
+        .from = s,
+        .fromX = x,
+        .startSpeed = dir*move.speed*PLAYER_MAX_HORIZONTAL_VELOCITY,
+        .hold = move.holdTo > move.holdFrom ? dir : 0,
+        .holdFrom = move.holdFrom,
+        .holdTo = move.holdTo,
+        .jumpTicks = move.jumpTicks,
+        .dashTick = move.dashTick,
+    };
+    link.type = link_type(&link);
+    if(fly(nav, &link)) add_link(nav, links, first, link);
+}
+
+// The links are flown from the ends of the span and, for the spans a jump
+// can reach above it, from a few distances beside them so the player rises
+// past their edge before drifting over them
+static void add_air_links(NavGraph *nav, NavLinks *links, uint32_t s, size_t first) {
+    NavSpan span = nav->spans[s];
+
+    float launches[NAV_MAX_LAUNCHES];
+    size_t launchCount = 0;
+    add_launch(launches, &launchCount, span, span.x0);
+    add_launch(launches, &launchCount, span, span.x1);
+
+    Rectangle above = {
+        span.x0 - PLAYER_WIDTH,
+        span.y - NAV_JUMP_HEIGHT,
+        span.x1 - span.x0 + 2*PLAYER_WIDTH,
+        NAV_JUMP_HEIGHT - 1,
+    };
+    uint32_t found[NAV_MAX_CANDIDATES];
+    size_t count = static_index_query(&nav->lookup, above, NAV_FILTER, found, NAV_MAX_CANDIDATES);
+    for(size_t i = 0; i < count; i++) {
+        NavSpan target = nav->spans[nav->lookup.source[found[i]]];
+        for(size_t k = 0; k < ARRAY_LEN(LAUNCH_DISTANCES); k++) {
+            add_launch(launches, &launchCount, span, target.x0 - LAUNCH_DISTANCES[k]*PLAYER_WIDTH);
+            add_launch(launches, &launchCount, span, target.x1 + LAUNCH_DISTANCES[k]*PLAYER_WIDTH);
+        }
+    }
+
+    if(span.openLeft) {
+        for(size_t m = 0; m < ARRAY_LEN(WALK_OFF); m++) fly_move(nav, links, first, s, span.x0, -1, WALK_OFF[m]);
+    }
+    if(span.openRight) {
+        for(size_t m = 0; m < ARRAY_LEN(WALK_OFF); m++) fly_move(nav, links, first, s, span.x1, 1, WALK_OFF[m]);
+    }
+
+    for(size_t l = 0; l < launchCount; l++) {
+        for(int dir = -1; dir <= 1; dir += 2) {
+            for(size_t m = 0; m < ARRAY_LEN(TAKE_OFF); m++) {
+                NavMove move = TAKE_OFF[m];
+                // straight up is the same both ways
+                if(dir < 0 && move.speed == 0 && move.holdTo == 0) continue;
+                fly_move(nav, links, first, s, launches[l], dir, move);
+            }
+        }
+    }
+}
+
+void nav_build(NavGraph *nav, const Collider *colliders, size_t count) {
+    *nav = (NavGraph){0};
+    collision_world_build(&nav->solids, colliders, count);
+
+    NavSpans spans = {0};
+    for(size_t i = 0; i < count; i++) {
+        if(!collision_filter_accepts(NAV_FILTER, colliders[i].category, colliders[i].mask)) continue;
+        add_spans(&spans, &nav->solids.statics, colliders[i]);
+    }
+    nav->spans = spans.items;
+    nav->spanCount = spans.count;
+
+    // the boxes cover every point the player stands on, its center can be
+    // half its width past the end of a span
+    Collider *boxes = mem_alloc(MEM_TAG_SCRATCH, (spans.count > 0 ? spans.count : 1)*sizeof(Collider));
+    assert(boxes != NULL && "No enough ram");
+    nav->bottom = -INFINITY;
+    for(size_t s = 0; s < spans.count; s++) {
+        NavSpan span = spans.items[s];
+        boxes[s] = (Collider) {
+            .x = span.x0 - PLAYER_WIDTH/2.0f,
+            .y = span.y,
+            .width = span.x1 - span.x0 + PLAYER_WIDTH,
+            .height = 1,
+            .category = COLLISION_LAYER_SOLID,
+            .mask = COLLISION_LAYER_PLAYER,
+        };
+        nav->bottom = fmaxf(nav->bottom, span.y);
+    }
+    static_index_build_in_order(&nav->lookup, boxes, spans.count);
+    mem_free(boxes);
+
+    // spans are done in order, so the links end up sorted by the span they leave
+    NavLinks links = {0};
+    nav->linkStart = alloc_array(spans.count + 1, sizeof(uint32_t));
+    for(uint32_t s = 0; s < spans.count; s++) {
+        size_t first = links.count;
+        nav->linkStart[s] = (uint32_t)first;
+        add_walk_links(nav, &links, s, first);
+        add_air_links(nav, &links, s, first);
+    }
+    nav->linkStart[spans.count] = (uint32_t)links.count;
+    nav->links = links.items;
+    nav->linkCount = links.count;
+    for(size_t i = 0; i < links.count; i++) nav->linkCounts[links.items[i].type]++;
+
+    nav->cost = alloc_array(spans.count, sizeof(float));
+    nav->entryX = alloc_array(spans.count, sizeof(float));
+    nav->via = alloc_array(spans.count, sizeof(uint32_t));
+    nav->seen = mem_calloc(MEM_TAG_PHYSICS, spans.count > 0 ? spans.count : 1, sizeof(uint32_t));
+    assert(nav->seen != NULL && "No enough ram");
+    nav->heap = alloc_array(links.count + 1, sizeof(NavHeapItem));
+}
+
+void nav_free(NavGraph *nav) {
+    mem_free(nav->spans);
+    mem_free(nav->links);
+    mem_free(nav->linkStart);
+    collision_world_free(&nav->solids);
+    static_index_free(&nav->lookup);
+    mem_free(nav->cost);
+    mem_free(nav->entryX);
+    mem_free(nav->via);
+    mem_free(nav->seen);
+    mem_free(nav->heap);
+    *nav = (NavGraph){0};
+}
+
+static void heap_push(NavGraph *nav, float f, uint32_t span) {
+    // every push follows a link, so there's room unless a span is settled twice
+    if(nav->heapCount == nav->linkCount + 1) return;
+
+    size_t i = nav->heapCount++;
+    while(i > 0) {
+        size_t parent = (i - 1)/2;
+        if(nav->heap[parent].f <= f) break;
+        nav->heap[i] = nav->heap[parent];
+        i = parent;
+    }
+    nav->heap[i] = (NavHeapItem){ f, span };
+}
+
+static NavHeapItem heap_pop(NavGraph *nav) {
+    NavHeapItem top = nav->heap[0];
+    NavHeapItem last = nav->heap[--nav->heapCount];
+
+    size_t i = 0;
+    for(;;) {
+        size_t child = 2*i + 1;
+        if(child >= nav->heapCount) break;
+        if(child + 1 < nav->heapCount && nav->heap[child + 1].f < nav->heap[child].f) child++;
+        if(last.f <= nav->heap[child].f) break;
+        nav->heap[i] = nav->heap[child];
+        i = child;
+    }
+    nav->heap[i] = last;
+    return top;
+}
+
+// Dashing is the fastest way to cover ground, so this never overestimates
+static float heuristic(const NavSpan *goal, float x) {
+    return fmaxf(fmaxf(goal->x0 - x, x - goal->x1), 0)/PLAYER_DASH_SPEED;
+}
+
+bool nav_find_path(NavGraph *nav, uint32_t from, float fromX, uint32_t to, NavPath *path) {
+    path->count = 0;
+    path->time = 0;
+    if(from >= nav->spanCount || to >= nav->spanCount) return false;
+    if(from == to) return true;
+
+    // a new stamp makes every cost stale at once
+    if(++nav->search == 0) {
+        memset(nav->seen, 0, nav->spanCount*sizeof(uint32_t));
+        nav->search = 1;
+    }
+    uint32_t search = nav->search;
+    const NavSpan *goal = &nav->spans[to];
+
+    nav->seen[from] = search;
+    nav->cost[from] = 0;
+    nav->entryX[from] = fromX;
+    nav->via[from] = NAV_NONE;
+    nav->heapCount = 0;
+    heap_push(nav, heuristic(goal, fromX), from);
+
+    while(nav->heapCount > 0) {
+        NavHeapItem item = heap_pop(nav);
+        uint32_t s = item.span;
+        // pushed again with a lower cost since
+        if(item.f > nav->cost[s] + heuristic(goal, nav->entryX[s])) continue;
+        if(s == to) break;
+
+        for(uint32_t k = nav->linkStart[s]; k < nav->linkStart[s + 1]; k++) {
+            const NavLink *link = &nav->links[k];
+            float cost = nav->cost[s] + fabsf(link->fromX - nav->entryX[s])/PLAYER_MAX_HORIZONTAL_VELOCITY +
+                         link->ticks*NAV_DT;
+            if(nav->seen[link->to] == search && cost >= nav->cost[link->to]) continue;
+
+            nav->seen[link->to] = search;
+            nav->cost[link->to] = cost;
+            nav->entryX[link->to] = link->toX;
+            nav->via[link->to] = k;
+            heap_push(nav, cost + heuristic(goal, link->toX), link->to);
+        }
+    }
+    if(nav->seen[to] != search) return false;
+
+    uint32_t count = 0;
+    for(uint32_t s = to; s != from; s = nav->links[nav->via[s]].from) {
+        if(++count > NAV_MAX_PATH) return false;
+    }
+    path->count = count;
+    path->time = nav->cost[to];
+    for(uint32_t s = to; s != from; s = nav->links[nav->via[s]].from) {
+        path->links[--count] = nav->via[s];
+    }
+    return true;
+}
+
+void nav_cache_init(NavPathCache *cache, size_t capacity) {
+    size_t slots = 1;
+    while(slots < capacity) slots <<= 1;
+
+    *cache = (NavPathCache) {
+        .entries = mem_alloc(MEM_TAG_PHYSICS, slots*sizeof(NavCacheEntry)),
+        .capacity = slots,
+    };
+    assert(cache->entries != NULL && "No enough ram");
+    nav_cache_clear(cache);
+}
+
+void nav_cache_free(NavPathCache *cache) {
+    mem_free(cache->entries);
+    *cache = (NavPathCache){0};
+}
+
+void nav_cache_clear(NavPathCache *cache) {
+    for(size_t i = 0; i < cache->capacity; i++) {
+        cache->entries[i].from = NAV_NONE;
+        cache->entries[i].to = NAV_NONE;
+    }
+    cache->hits = 0;
+    cache->misses = 0;
+}
+
+const NavPath *nav_cache_find(NavPathCache *cache, NavGraph *nav, uint32_t from, float fromX, uint32_t to) {
+    size_t slot = ((size_t)from*2654435761u ^ (size_t)to*2246822519u) & (cache->capacity - 1);
+    NavCacheEntry *entry = &cache->entries[slot];
+
+    if(entry->from == from && entry->to == to) {
+        cache->hits++;
+    } else {
+        cache->misses++;
+        entry->from = from;
+        entry->to = to;
+        entry->found = nav_find_path(nav, from, fromX, to, &entry->path);
+    }
+    return entry->found ? &entry->path : NULL;
+}
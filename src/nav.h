@@ -0,0 +1,135 @@
+#ifndef NAV_H
+#define NAV_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "raylib.h"
+#include "collision.h"
+#include "player.h"
+
+#define NAV_NONE 0xffffffffu
+#define NAV_MAX_PATH 32 // links, longer paths are not found
+#define NAV_DT (1.0f/60) // tick the links were flown at, replaying them at another one drifts
+#define NAV_MAX_TICKS 180 // longer links are dropped
+
+// Where the player can stand on top of a collider: the range of its center
+// and the y of its feet. An end that is the edge of the collider can be
+// walked off, one cut by a wall can't.
+typedef struct {
+    float x0;
+    float x1;
+    float y;
+    bool openLeft;
+    bool openRight;
+} NavSpan;
+
+typedef enum {
+    NAV_LINK_WALK,
+    NAV_LINK_FALL,
+    NAV_LINK_JUMP,
+    NAV_LINK_DASH,
+} NavLinkType;
+
+// How to go from a span to another. Stand with the center at fromX going at
+// startSpeed, then give the inputs of nav_link_input for ticks ticks: hold
+// (-1 for left, 1 for right) is pressed from the tick holdFrom to holdTo,
+// jump is held for jumpTicks (0 for no jump) and dash is pressed on dashTick
+// (-1 for no dash). The player lands on the span to with the center at toX.
+typedef struct {
+    uint32_t from;
+    uint32_t to;
+    NavLinkType type;
+    float fromX;
+    float toX;
+    float startSpeed;
+    int hold;
+    int holdFrom;
+    int holdTo;
+    int jumpTicks;
+    int dashTick;
+    int ticks;
+} NavLink;
+
+typedef struct {
+    float f;
+    uint32_t span;
+} NavHeapItem;
+
+// The walkable spans of a level and the links between them. Every link was
+// flown with the arcs of the player against the colliders and replayed with
+// player_step from its start and a unit to each side, so an agent that moves
+// like the player and replays the inputs of a link near its start gets there.
+typedef struct {
+    NavSpan *spans;
+    size_t spanCount;
+    NavLink *links; // sorted by from, the ones of span s are [linkStart[s], linkStart[s + 1])
+    size_t linkCount;
+    uint32_t *linkStart;
+    size_t linkCounts[4]; // per type
+    float bottom; // of the lowest span, a player below it falls forever
+
+    CollisionWorld solids; // the level, the links are flown against it
+    StaticIndex lookup; // a thin box on every span, to find where a point stands
+
+    // A* state, reset by bumping search instead of clearing
+    float *cost;
+    float *entryX;
+    uint32_t *via; // link that reached the span
+    uint32_t *seen;
+    uint32_t search;
+    NavHeapItem *heap; // may hold a span more than once, the stale ones are skipped
+    size_t heapCount;
+} NavGraph;
+
+typedef struct {
+    uint32_t links[NAV_MAX_PATH];
+    uint32_t count;
+    float time; // estimated, walking included
+} NavPath;
+
+// Builds the graph over the solid static colliders of a level. Load time
+// work, every candidate link is flown as arcs of the player and the ones
+// that land are stepped to confirm them.
+void nav_build(NavGraph *nav, const Collider *colliders, size_t count);
+void nav_free(NavGraph *nav);
+
+// The player a link starts from and what it presses on a tick of the link
+Player nav_link_start(const NavGraph *nav, const NavLink *link);
+PlayerInput nav_link_input(const NavLink *link, int tick);
+
+// The span under feet, searching down to maxDrop below them. NAV_NONE when
+// there's none.
+uint32_t nav_locate(const NavGraph *nav, Vector2 feet, float maxDrop);
+
+// A* over the spans, the cost of a link is its time plus the walk to where
+// it starts from where the span was entered. Returns false when there's no
+// path of at most NAV_MAX_PATH links. It uses the scratch of the graph, so
+// only one thread can search a graph at a time.
+bool nav_find_path(NavGraph *nav, uint32_t from, float fromX, uint32_t to, NavPath *path);
+
+typedef struct {
+    uint32_t from;
+    uint32_t to;
+    bool found;
+    NavPath path;
+} NavCacheEntry;
+
+// Paths between spans shared by every agent. It's direct mapped, a new pair
+// takes the place of whatever had its slot. The path of a pair is the one
+// found for the first agent that asked, wherever it stood on the span.
+typedef struct {
+    NavCacheEntry *entries;
+    size_t capacity; // power of two
+    size_t hits;
+    size_t misses;
+} NavPathCache;
+
+void nav_cache_init(NavPathCache *cache, size_t capacity);
+void nav_cache_free(NavPathCache *cache);
+// Forgets every path, after the graph was built again
+void nav_cache_clear(NavPathCache *cache);
+// NULL when there's no path, valid until the next call
+const NavPath *nav_cache_find(NavPathCache *cache, NavGraph *nav, uint32_t from, float fromX, uint32_t to);
+
+#endif // NAV_H
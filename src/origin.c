@@ -0,0 +1,37 @@
+#include <math.h>
+
+#include "origin.h"
+
+Vector2 origin_rebase_delta(Vector2 pos) {
+    Vector2 delta = { 0, 0 };
+    if(fabsf(pos.x) > ORIGIN_THRESHOLD) delta.x = -roundf(pos.x/ORIGIN_QUANTUM)*ORIGIN_QUANTUM;
+    if(fabsf(pos.y) > ORIGIN_THRESHOLD) delta.y = -roundf(pos.y/ORIGIN_QUANTUM)*ORIGIN_QUANTUM;
+    return delta;
+}
+
+void origin_shift(Game *game, Vector2 delta) {
+    game->player.pos.x += delta.x;
+    game->player.pos.y += delta.y;
+    game->camera.target.x += delta.x;
+    game->camera.target.y += delta.y;
+    game->spawn.x += delta.x;
+    game->spawn.y += delta.y;
+
+    collision_world_shift(&game->collision, delta);
+    tilemap_shift(&game->tiles, delta);
+    trigger_set_shift(&game->triggers, delta);
+    moving_platforms_shift(&game->moving, delta);
+    particles_shift(&game->particles, delta);
+    projectiles_shift(&game->projectiles, delta);
+
+    game->originX -= (int64_t)delta.x;
+    game->originY -= (int64_t)delta.y;
+}
+
+bool origin_rebase(Game *game) {
+    Vector2 delta = origin_rebase_delta(game->player.pos);
+    if(delta.x == 0 && delta.y == 0) return false;
+
+    origin_shift(game, delta);
+    return true;
+}
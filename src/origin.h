@@ -0,0 +1,28 @@
+#ifndef ORIGIN_H
+#define ORIGIN_H
+
+#include <stdbool.h>
+#include "raylib.h"
+#include "game.h"
+
+// Power of two and a multiple of the dynamic cell size, moving a float by a
+// multiple of it is exact as long as the float is a multiple of its ulp
+#define ORIGIN_QUANTUM 16384
+// How far the player goes from the origin before it's moved, a few quanta so
+// walking back and forth over a boundary doesn't rebase every frame
+#define ORIGIN_THRESHOLD (2*ORIGIN_QUANTUM)
+
+// How much everything has to move to bring pos back near the origin, zero
+// while it's inside the threshold
+Vector2 origin_rebase_delta(Vector2 pos);
+
+// Moves every position of the game by delta in one pass: player, camera,
+// spawn, static and dynamic colliders, tiles, triggers, moving platforms,
+// particles and projectiles
+void origin_shift(Game *game, Vector2 delta);
+
+// Rebases the game on the player when it went past the threshold, returns
+// true when it did
+bool origin_rebase(Game *game);
+
+#endif // ORIGIN_H
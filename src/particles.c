@@ -0,0 +1,203 @@
+#include <math.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "particles.h"
+#include "mem.h"
+#include "rlgl.h"
+
+// zeroed, the padding lanes are integrated too and must hold numbers
+static void *alloc_lanes(size_t capacity, size_t size) {
+    return mem_calloc(MEM_TAG_RENDER, capacity, size);
+}
+
+void particles_init(ParticleSystem *ps, size_t capacity, float gravity, float drag) {
+    capacity = (capacity + 3) & ~(size_t)3;
+    *ps = (ParticleSystem) {
+        .x = alloc_lanes(capacity, sizeof(float)),
+        .y = alloc_lanes(capacity, sizeof(float)),
+        .vx = alloc_lanes(capacity, sizeof(float)),
+        .vy = alloc_lanes(capacity, sizeof(float)),
+        .life = alloc_lanes(capacity, sizeof(float)),
+        .invLife = alloc_lanes(capacity, sizeof(float)),
+        .size = alloc_lanes(capacity, sizeof(float)),
+        .color = alloc_lanes(capacity, sizeof(Color)),
+        .capacity = capacity,
+        .gravity = gravity,
+        .drag = drag,
+        .seed = 0x9e3779b9u,
+    };
+
+    // over the render budget the game goes on without particles, every
+    // emit is dropped
+    if(ps->x == NULL || ps->y == NULL || ps->vx == NULL || ps->vy == NULL || ps->life == NULL ||
+       ps->invLife == NULL || ps->size == NULL || ps->color == NULL) {
+        particles_free(ps);
+        ps->gravity = gravity;
+        ps->drag = drag;
+        ps->seed = 0x9e3779b9u;
+    }
+}
+
+void particles_free(ParticleSystem *ps) {
+    mem_free(ps->x);
+    mem_free(ps->y);
+    mem_free(ps->vx);
+    mem_free(ps->vy);
+    mem_free(ps->life);
+    mem_free(ps->invLife);
+    mem_free(ps->size);
+    mem_free(ps->color);
+    *ps = (ParticleSystem){0};
+}
+
+// xorshift, in [-1, 1]
+static float noise(ParticleSystem *ps) {
+    uint32_t s = ps->seed;
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    ps->seed = s;
+    return (float)(s >> 8)*(2.0f/16777215.0f) - 1;
+}
+
+void particles_emit(ParticleSystem *ps, const ParticleEmitter *emitter, Vector2 pos, size_t count) {
+    if(count > ps->capacity - ps->count) {
+        ps->dropped += count - (ps->capacity - ps->count);
+        count = ps->capacity - ps->count;
+    }
+
+    for(size_t n = 0; n < count; n++) {
+        size_t i = ps->count++;
+        float life = fmaxf(emitter->life + emitter->lifeSpread*noise(ps), 0.001f);
+        ps->x[i] = pos.x + emitter->offsetSpread.x*noise(ps);
+        ps->y[i] = pos.y + emitter->offsetSpread.y*noise(ps);
+        ps->vx[i] = emitter->velocity.x + emitter->velocitySpread.x*noise(ps);
+        ps->vy[i] = emitter->velocity.y + emitter->velocitySpread.y*noise(ps);
+        ps->life[i] = life;
+        ps->invLife[i] = 1/life;
+        ps->size[i] = emitter->size;
+        ps->color[i] = emitter->color;
+    }
+}
+
+// groups of 4 particles per job
+#define PARTICLES_GRAIN 1024
+
+// Over the particles [begin, end), both multiples of 4. The capacity is a
+// multiple of 4 too, so the last group runs over the padding instead of
+// needing a scalar tail
+static void integrate_range(ParticleSystem *ps, size_t begin, size_t end, float dt) {
+    float damp = fmaxf(1 - ps->drag*dt, 0);
+    float fall = ps->gravity*dt;
+
+#ifdef __SSE2__
+    __m128 vdt = _mm_set1_ps(dt);
+    __m128 vdamp = _mm_set1_ps(damp);
+    __m128 vfall = _mm_set1_ps(fall);
+    for(size_t i = begin; i < end; i += 4) {
+        __m128 vx = _mm_mul_ps(_mm_loadu_ps(ps->vx + i), vdamp);
+        __m128 vy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(ps->vy + i), vdamp), vfall);
+        _mm_storeu_ps(ps->vx + i, vx);
+        _mm_storeu_ps(ps->vy + i, vy);
+        _mm_storeu_ps(ps->x + i, _mm_add_ps(_mm_loadu_ps(ps->x + i), _mm_mul_ps(vx, vdt)));
+        _mm_storeu_ps(ps->y + i, _mm_add_ps(_mm_loadu_ps(ps->y + i), _mm_mul_ps(vy, vdt)));
+        _mm_storeu_ps(ps->life + i, _mm_sub_ps(_mm_loadu_ps(ps->life + i), vdt));
+    }
+#else
+    for(size_t i = begin; i < end; i++) {
+        ps->vx[i] *= damp;
+        ps->vy[i] = ps->vy[i]*damp + fall;
+        ps->x[i] += ps->vx[i]*dt;
+        ps->y[i] += ps->vy[i]*dt;
+        ps->life[i] -= dt;
+    }
+#endif
+}
+
+typedef struct {
+    ParticleSystem *ps;
+    float dt;
+} IntegrateJob;
+
+static void integrate_groups(void *data, size_t begin, size_t end) {
+    IntegrateJob *job = data;
+    integrate_range(job->ps, begin*4, end*4, job->dt);
+}
+
+static void move_particle(ParticleSystem *ps, size_t to, size_t from) {
+    ps->x[to] = ps->x[from];
+    ps->y[to] = ps->y[from];
+    ps->vx[to] = ps->vx[from];
+    ps->vy[to] = ps->vy[from];
+    ps->life[to] = ps->life[from];
+    ps->invLife[to] = ps->invLife[from];
+    ps->size[to] = ps->size[from];
+    ps->color[to] = ps->color[from];
+}
+
+// The last particle takes the place of each dead one, which is checked again
+// since the last may be dead too
+static void remove_dead(ParticleSystem *ps) {
+    size_t i = 0;
+    while(i < ps->count) {
+#ifdef __SSE2__
+        // most groups have nobody dying this tick
+        if(i + 4 <= ps->count) {
+            __m128 dead = _mm_cmple_ps(_mm_loadu_ps(ps->life + i), _mm_setzero_ps());
+            if(_mm_movemask_ps(dead) == 0) {
+                i += 4;
+                continue;
+            }
+        }
+#endif
+        if(ps->life[i] > 0) {
+            i++;
+            continue;
+        }
+        move_particle(ps, i, --ps->count);
+    }
+}
+
+void particles_update(ParticleSystem *ps, float dt) {
+    integrate_range(ps, 0, (ps->count + 3) & ~(size_t)3, dt);
+    remove_dead(ps);
+}
+
+void particles_update_parallel(JobSystem *js, ParticleSystem *ps, float dt) {
+    IntegrateJob job = { .ps = ps, .dt = dt };
+    jobs_parallel_for(js, (ps->count + 3)/4, PARTICLES_GRAIN, integrate_groups, &job);
+    remove_dead(ps);
+}
+
+void particles_shift(ParticleSystem *ps, Vector2 delta) {
+    for(size_t i = 0; i < ps->count; i++) {
+        ps->x[i] += delta.x;
+        ps->y[i] += delta.y;
+    }
+}
+
+void particles_draw(const ParticleSystem *ps) {
+    if(ps->count == 0) return;
+
+    // a single quad batch with the white texture, raylib flushes it when full
+    rlSetTexture(rlGetTextureIdDefault());
+    rlBegin(RL_QUADS);
+    for(size_t i = 0; i < ps->count; i++) {
+        Color c = ps->color[i];
+        float fade = fminf(ps->life[i]*ps->invLife[i], 1);
+        float half = ps->size[i]*0.5f;
+        float x = ps->x[i], y = ps->y[i];
+
+        rlColor4ub(c.r, c.g, c.b, (unsigned char)(c.a*fade));
+        rlVertex2f(x - half, y - half);
+        rlVertex2f(x - half, y + half);
+        rlVertex2f(x + half, y + half);
+        rlVertex2f(x + half, y - half);
+    }
+    rlEnd();
+    rlSetTexture(0);
+}
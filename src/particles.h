@@ -0,0 +1,57 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "raylib.h"
+#include "jobs.h"
+
+// How a burst of particles starts, every value gets up to spread of noise
+typedef struct {
+    Vector2 velocity;
+    Vector2 velocitySpread;
+    Vector2 offsetSpread; // around the emit position
+    float life; // seconds
+    float lifeSpread;
+    float size;
+    Color color;
+} ParticleEmitter;
+
+// Short lived quads that only move. They are stored as SoA and integrated 4
+// at a time, a dead one is replaced by the last so the live ones stay packed
+// in [0, count). The capacity is allocated once, bursts that don't fit are
+// cut and counted in dropped.
+typedef struct {
+    float *x;
+    float *y;
+    float *vx;
+    float *vy;
+    float *life; // left, the particle dies at 0
+    float *invLife; // 1/life at spawn, for the fade
+    float *size;
+    Color *color;
+    size_t count;
+    size_t capacity; // a multiple of 4, the lanes past count are padding
+
+    float gravity;
+    float drag; // fraction of the velocity lost per second
+    uint32_t seed;
+    size_t dropped;
+} ParticleSystem;
+
+// The capacity is 0 when the render budget refuses the lanes
+void particles_init(ParticleSystem *ps, size_t capacity, float gravity, float drag);
+void particles_free(ParticleSystem *ps);
+
+void particles_emit(ParticleSystem *ps, const ParticleEmitter *emitter, Vector2 pos, size_t count);
+// Moves every particle and removes the ones whose life ran out
+void particles_update(ParticleSystem *ps, float dt);
+// Same as particles_update with the integration split over the job system,
+// the removal stays serial since it reorders the lanes
+void particles_update_parallel(JobSystem *js, ParticleSystem *ps, float dt);
+void particles_shift(ParticleSystem *ps, Vector2 delta);
+
+// One batch of quads for all of them, inside BeginMode2D
+void particles_draw(const ParticleSystem *ps);
+
+#endif // PARTICLES_H
@@ -2,40 +2,32 @@
 
 #include "player.h"
 
-#define PLAYER_GRAVITY 3000 // the force in which the player is pulled down
-#define PLAYER_MAX_FALL_VELOCITY 4000 // max vertical speed caused by gravity
-#define PLAYER_FALL_VELOCITY_WHEN_HUGGING_WALL 200
-
-#define PLAYER_DASH_SPEED 5000 // the speed of the dash
-#define PLAYER_DASH_DURATION 0.1 // duration of the dash
-
-#define PLAYER_HORIZONTAL_FORCE 7000
-#define PLAYER_MAX_HORIZONTAL_VELOCITY 1000
-
-#define PLAYER_JUMP_FORCE 6500
-#define PLAYER_JUMP_DURATION 0.3
+#define DEBUG_CCD 1
 
-#define PLAYER_WIDTH 60
-#define PLAYER_HEIGHT 120
+#define PLAYER_MAX_CANDIDATES 64 // colliders gathered for a single tick
+#define PLAYER_MAX_CONTACTS 16 // overlaps resolved by each axis
+#define PLAYER_ARC_CHUNK 16 // ticks of an arc tested with a single query
+#define PLAYER_FLOOR_EPSILON 0.01f // the feet are one rounding away from the top they were pushed on
 
-#define DEBUG_CCD 1
+static const CollisionFilter PLAYER_FILTER = {
+    .category = COLLISION_LAYER_PLAYER,
+    .mask = COLLISION_LAYER_SOLID,
+};
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
-static void gravity(Player *player) {
-    float dt = GetFrameTime();
+static void gravity(Player *player, float dt) {
     float max = player->huggingWall ? PLAYER_FALL_VELOCITY_WHEN_HUGGING_WALL : PLAYER_MAX_FALL_VELOCITY;
     player->vel.y = MIN(max, player->vel.y + PLAYER_GRAVITY * dt);
 }
 
-static void dash(Player *player) {
+static void dash(Player *player, PlayerInput input, float dt) {
     if(player->huggingWall) return;
 
-    float dt = GetFrameTime();
-
-    if(IsKeyPressed(KEY_C)) {
+    if(input.dashPressed) {
         player->dashing = true;
+        player->dashStarted = true;
         player->vel.x = PLAYER_DASH_SPEED * player->dir;
     }
 
@@ -51,14 +43,13 @@ static void dash(Player *player) {
     }
 }
 
-static void movement(Player *player) {
+static void movement(Player *player, PlayerInput input, float dt) {
     if(player->dashing) return;
-    float dt = GetFrameTime();
 
-    if(IsKeyDown(KEY_RIGHT)) {
+    if(input.right) {
         player->vel.x += PLAYER_HORIZONTAL_FORCE * dt;
         player->dir = PLAYER_DIR_RIGHT;
-    } else if(IsKeyDown(KEY_LEFT)) {
+    } else if(input.left) {
         player->vel.x -= PLAYER_HORIZONTAL_FORCE * dt;
         player->dir = PLAYER_DIR_LEFT;
     } else if(player->vel.x != 0) {
@@ -77,15 +68,13 @@ static void movement(Player *player) {
     }
 }
 
-static void jump(Player *player) {
-    float dt = GetFrameTime();
-
-    if(IsKeyPressed(KEY_Z) && player->isOnFloor) {
+static void jump(Player *player, PlayerInput input, float dt) {
+    if(input.jumpPressed && player->isOnFloor) {
         player->jumping = true;
         player->jumpTime = 0;
     }
 
-    if(player->jumping && (IsKeyReleased(KEY_Z) || player->jumpTime >= PLAYER_JUMP_DURATION)) {
+    if(player->jumping && (input.jumpReleased || player->jumpTime >= PLAYER_JUMP_DURATION)) {
         player->jumping = false;
     }
 
@@ -95,6 +84,37 @@ static void jump(Player *player) {
     }
 }
 
+Rectangle player_get_rec(const Player *player) {
+    return (Rectangle) {
+        .x = player->pos.x,
+        .y = player->pos.y,
+        .width = PLAYER_WIDTH,
+        .height = PLAYER_HEIGHT,
+    };
+}
+
+// The colliders that the player can touch this tick, gathered once with the
+// box swept by the whole movement and shared by both axes.
+typedef struct {
+    Collider items[PLAYER_MAX_CANDIDATES];
+    ColliderRef refs[PLAYER_MAX_CANDIDATES];
+    size_t count;
+} Candidates;
+
+static void gather_candidates(Candidates *cands, const Player *player, const CollisionWorld *world, float dt) {
+    float dx = player->vel.x * dt;
+    float dy = player->vel.y * dt;
+
+    Rectangle swept = {
+        .x = player->pos.x + MIN(0, dx),
+        .y = player->pos.y + MIN(0, dy),
+        .width = PLAYER_WIDTH + fabsf(dx),
+        .height = PLAYER_HEIGHT + fabsf(dy),
+    };
+
+    cands->count = collision_query(world, swept, PLAYER_FILTER, cands->items, cands->refs, PLAYER_MAX_CANDIDATES);
+}
+
 static Rectangle get_rec_from_collider(Collider coll) {
     return (Rectangle) {
         .x = coll.x,
@@ -104,80 +124,490 @@ static Rectangle get_rec_from_collider(Collider coll) {
     };
 }
 
-static Collider *get_collision(Colliders colliders, Player *player) {
-    Rectangle playerRec = {
-        .x = player->pos.x,
-        .y = player->pos.y,
-        .width = PLAYER_WIDTH,
-        .height = PLAYER_HEIGHT,
-    };
-
-    for(size_t i = 0; i < colliders.count; i++) {
-        Collider *coll = &colliders.items[i];
-        Rectangle collRec = get_rec_from_collider(colliders.items[i]);
-
-        if(CheckCollisionRecs(collRec, playerRec)) {
-            return coll;
-        }
+// Pushes the player out of the contacts from the smallest translation to the
+// largest. A contact that an earlier push already separated is skipped, so
+// everything is resolved in the same tick.
+static void resolve_contacts(Player *player, const Contact *contacts, size_t count) {
+    for(size_t i = 0; i < count; i++) {
+        Collider coll = contacts[i].collider;
+        if(!CheckCollisionRecs(get_rec_from_collider(coll), player_get_rec(player))) continue;
+
+        Vector2 normal = contacts[i].normal;
+        if(normal.x < 0) player->pos.x = coll.x - PLAYER_WIDTH;
+        else if(normal.x > 0) player->pos.x = coll.x + coll.width;
+        else if(normal.y < 0) player->pos.y = coll.y - PLAYER_HEIGHT;
+        else if(normal.y > 0) player->pos.y = coll.y + coll.height;
     }
-
-    return NULL;
 }
 
-static void collision_x_axis(Game *game) {
-    float dt = GetFrameTime();
-    Player *player = &game->player;
+static void collision_x_axis(Player *player, const Candidates *cands, float dt) {
     player->pos.x += player->vel.x * dt;
 
-    Collider *coll = get_collision(game->colliders, player);
-    if(coll != NULL) {
+    Contact contacts[PLAYER_MAX_CONTACTS];
+    size_t count = collision_contacts(cands->items, cands->refs, cands->count, player_get_rec(player),
+                                      (Vector2){ player->vel.x, 0 }, PLAYER_FILTER, contacts, PLAYER_MAX_CONTACTS);
+
+    if(count > 0) {
         if(!player->jumping && !player->isOnFloor) {
             player->huggingWall = true;
         }
 
-        if(player->vel.x > 0) {
-            player->vel.x = 0;
-            player->pos.x = coll->x - PLAYER_WIDTH;
-        } else if(player->vel.x < 0) {
+        if(player->vel.x != 0) {
+            resolve_contacts(player, contacts, count);
             player->vel.x = 0;
-            player->pos.x = coll->x + coll->width;
         }
     } else if(player->huggingWall) {
         player->huggingWall = false;
     }
 }
 
-static void collision_y_axis(Game *game) {
-    float dt = GetFrameTime();
-    Player *player = &game->player;
+static void collision_y_axis(Player *player, const Candidates *cands, float dt) {
+    bool wasOnFloor = player->isOnFloor;
     player->pos.y += player->vel.y * dt;
     player->isOnFloor = false;
+    player->riding = COLLIDER_REF_NONE;
 
-    Collider *coll = get_collision(game->colliders, player);
-    if(coll != NULL) {
+    Contact contacts[PLAYER_MAX_CONTACTS];
+    size_t count = collision_contacts(cands->items, cands->refs, cands->count, player_get_rec(player),
+                                      (Vector2){ 0, player->vel.y }, PLAYER_FILTER, contacts, PLAYER_MAX_CONTACTS);
+
+    if(count > 0) {
         if(player->vel.y > 0) {
+            resolve_contacts(player, contacts, count);
             player->vel.y = 0;
-            player->pos.y = coll->y - PLAYER_HEIGHT;
             player->isOnFloor = true;
+            player->landed = !wasOnFloor;
+
+            // remember what it landed on, a moving collider wins over a static one
+            float feet = player->pos.y + PLAYER_HEIGHT;
+            for(size_t i = 0; i < count; i++) {
+                if(contacts[i].normal.y >= 0 || fabsf(contacts[i].collider.y - feet) > PLAYER_FLOOR_EPSILON) continue;
+                if(player->riding == COLLIDER_REF_NONE || (contacts[i].ref & COLLIDER_REF_DYNAMIC)) {
+                    player->riding = contacts[i].ref;
+                }
+            }
         } else if(player->vel.y < 0) {
+            resolve_contacts(player, contacts, count);
             player->vel.y = 0;
-            player->pos.y = coll->y + coll->height;
             player->jumping = false;
         }
     }
 }
 
-void player_update(Game *game) {
-    Player *player = &game->player;
+PlayerInput player_input_from_keyboard(void) {
+    return (PlayerInput) {
+        .left = IsKeyDown(KEY_LEFT),
+        .right = IsKeyDown(KEY_RIGHT),
+        .jumpPressed = IsKeyPressed(KEY_Z),
+        .jumpReleased = IsKeyReleased(KEY_Z),
+        .dashPressed = IsKeyPressed(KEY_C),
+    };
+}
+
+void player_step_free(Player *player, PlayerInput input, float dt) {
+    gravity(player, dt);
+    dash(player, input, dt);
+    movement(player, input, dt);
+    jump(player, input, dt);
+
+    player->pos.x += player->vel.x * dt;
+    player->pos.y += player->vel.y * dt;
+    player->isOnFloor = false;
+}
+
+void player_step(Player *player, const CollisionWorld *world, PlayerInput input, float dt) {
+    // follow the platform stood on last tick, its delta is all that's needed
+    Vector2 carry = collision_world_get_delta(world, player->riding);
+    player->pos.x += carry.x;
+    player->pos.y += carry.y;
+    player->dashStarted = false;
+    player->landed = false;
+
+    gravity(player, dt);
+    dash(player, input, dt);
+    movement(player, input, dt);
+    jump(player, input, dt);
+
+    Candidates cands;
+    gather_candidates(&cands, player, world, dt);
+
+    collision_x_axis(player, &cands, dt);
+    collision_y_axis(player, &cands, dt);
+}
+
+// Ticks the jump still pushes for, the time is summed like jump() does so it
+// stops on the same tick
+static int jump_ticks_left(float time, float dt) {
+    int n = 0;
+    while(time < PLAYER_JUMP_DURATION) {
+        time += dt;
+        n++;
+    }
+    return n;
+}
+
+// Ticks the dash goes on for before the one that ends it
+static int dash_ticks_left(float time, float dt) {
+    int n = 0;
+    for(;;) {
+        float next = time + dt;
+        if(next >= PLAYER_DASH_DURATION) return n;
+        time = next;
+        n++;
+    }
+}
+
+// Ticks before v + j*a changes sign, so a piece only goes one way
+static int ticks_before_turning(float v, float a, int max) {
+    if(a == 0 || (a > 0 ? v + a > 0 : v + a < 0)) return max;
+
+    int j = (int)ceilf(-v/a);
+    while(j > 1 && (a > 0 ? v + (j - 1)*a > 0 : v + (j - 1)*a < 0)) j--;
+    while(a > 0 ? v + j*a <= 0 : v + j*a >= 0) j++;
+    return MIN(max, j - 1);
+}
+
+// Ticks before v + j*a reaches limit, going up to it
+static int ticks_before_reaching(float v, float a, float limit, int max) {
+    int j = (int)ceilf((limit - v)/a);
+    if(j < 1) j = 1;
+    while(j > 1 && v + (j - 1)*a >= limit) j--;
+    while(v + j*a < limit) j++;
+    return MIN(max, j - 1);
+}
+
+// How the velocity of each axis changes over the next ticks: vel + j*accel
+// until one of them hits a cap, turns around or the jump or dash ends. No
+// ticks means the next one doesn't follow a line and has to be stepped.
+typedef struct {
+    int ticks;
+    Vector2 vel;
+    Vector2 accel;
+} ArcRegime;
+
+static ArcRegime arc_regime(const Player *player, PlayerInput held, float dt, int max) {
+    ArcRegime r = { .ticks = max };
+    bool jumping = player->jumping && player->jumpTime < PLAYER_JUMP_DURATION;
+    if(jumping) r.ticks = MIN(r.ticks, jump_ticks_left(player->jumpTime, dt));
+
+    // the velocity is held, the tick ending the dash resets it
+    if(player->dashing && !player->huggingWall) {
+        r.ticks = MIN(r.ticks, dash_ticks_left(player->dashTime, dt));
+        r.vel = (Vector2){ player->vel.x, jumping ? -PLAYER_JUMP_FORCE*dt : 0 };
+        return r;
+    }
+
+    float maxFall = player->huggingWall ? PLAYER_FALL_VELOCITY_WHEN_HUGGING_WALL : PLAYER_MAX_FALL_VELOCITY;
+    float fall = PLAYER_GRAVITY*dt;
+    float vy = player->vel.y;
+    if(jumping) {
+        if(vy + fall > maxFall) return (ArcRegime){0};
+        r.vel.y = vy;
+        r.accel.y = fall - PLAYER_JUMP_FORCE*dt;
+    } else if(vy + fall >= maxFall) {
+        r.vel.y = maxFall;
+    } else {
+        r.vel.y = vy;
+        r.accel.y = fall;
+        r.ticks = ticks_before_reaching(vy, fall, maxFall, r.ticks);
+    }
+    r.ticks = ticks_before_turning(r.vel.y, r.accel.y, r.ticks);
+
+    // a wall stops a dash without ending it, movement leaves it alone then
+    float push = PLAYER_HORIZONTAL_FORCE*dt;
+    float vx = player->vel.x;
+    int side = held.right ? 1 : held.left ? -1 : 0;
+    if(player->dashing) {
+        r.vel.x = vx;
+    } else if(fabsf(vx) > PLAYER_MAX_HORIZONTAL_VELOCITY) {
+        return (ArcRegime){0};
+    } else if(side != 0) {
+        if(side*vx + push >= PLAYER_MAX_HORIZONTAL_VELOCITY) {
+            r.vel.x = side*PLAYER_MAX_HORIZONTAL_VELOCITY;
+        } else {
+            r.vel.x = vx;
+            r.accel.x = side*push;
+            r.ticks = ticks_before_reaching(side*vx, push, PLAYER_MAX_HORIZONTAL_VELOCITY, r.ticks);
+            r.ticks = ticks_before_turning(vx, r.accel.x, r.ticks);
+        }
+    } else if(vx != 0) {
+        // slowing down until it snaps to 0 under 100, that tick is stepped
+        if(fabsf(vx) <= push) return (ArcRegime){0};
+        r.vel.x = vx;
+        r.accel.x = vx > 0 ? -push : push;
+        r.ticks = ticks_before_reaching(-fabsf(vx), push, -100, r.ticks);
+    }
+
+    return r;
+}
+
+// In double, rounded once, so it lands on the same float as the ticks summed
+// one by one as often as possible: levels are often on whole units
+static float piece_at(const PlayerArcPiece *piece, float dt, int tick) {
+    int j = tick - piece->start;
+    return (float)(piece->pos + (double)dt*(j*(double)piece->vel + piece->accel*(double)(j*(j + 1)/2)));
+}
+
+// Extends the last piece when it goes on with the same acceleration without
+// turning around, false when the arc has no room left
+static bool arc_push(PlayerArcPiece *pieces, int *count, PlayerArcPiece piece) {
+    if(*count > 0) {
+        PlayerArcPiece *last = &pieces[*count - 1];
+        float first = last->vel + last->accel;
+        float end = piece.vel + piece.count*piece.accel;
+        if(last->accel == piece.accel && last->vel + last->count*last->accel == piece.vel &&
+           !(first < 0 && end > 0) && !(first > 0 && end < 0)) {
+            last->count += piece.count;
+            return true;
+        }
+    }
+    if(*count == PLAYER_ARC_MAX_PIECES) return false;
+    pieces[(*count)++] = piece;
+    return true;
+}
+
+static bool arc_add(PlayerArc *arc, int start, int count, Vector2 pos, Vector2 vel, Vector2 accel) {
+    // both axes always cover the same ticks, so they are only added together
+    if(arc->xCount == PLAYER_ARC_MAX_PIECES || arc->yCount == PLAYER_ARC_MAX_PIECES) return false;
+    arc_push(arc->x, &arc->xCount, (PlayerArcPiece){ start, count, pos.x, vel.x, accel.x });
+    arc_push(arc->y, &arc->yCount, (PlayerArcPiece){ start, count, pos.y, vel.y, accel.y });
+    return true;
+}
+
+void player_arc(const Player *player, PlayerInput input, float dt, int ticks, PlayerArc *arc) {
+    arc->xCount = 0;
+    arc->yCount = 0;
+    arc->dt = dt;
+
+    Player p = *player;
+    PlayerInput held = { .left = input.left, .right = input.right };
+    int tick = 0;
+    while(tick < ticks && dt > 0) {
+        ArcRegime r = tick == 0 ? (ArcRegime){0} : arc_regime(&p, held, dt, ticks - tick);
+
+        if(r.ticks == 0) {
+            Vector2 start = p.pos;
+            Player next = p;
+            player_step_free(&next, tick == 0 ? input : held, dt);
+            if(!arc_add(arc, tick, 1, start, next.vel, (Vector2){0})) break;
+            p = next;
+            tick++;
+            continue;
+        }
 
-    gravity(player);
-    dash(player);
-    movement(player);
-    jump(player);
+        if(!arc_add(arc, tick, r.ticks, p.pos, r.vel, r.accel)) break;
+        int n = r.ticks;
+        PlayerArcPiece x = { 0, n, p.pos.x, r.vel.x, r.accel.x };
+        PlayerArcPiece y = { 0, n, p.pos.y, r.vel.y, r.accel.y };
+        p.pos = (Vector2){ piece_at(&x, dt, n), piece_at(&y, dt, n) };
+        p.vel = (Vector2){ r.vel.x + n*r.accel.x, r.vel.y + n*r.accel.y };
 
-    collision_x_axis(game);
-    collision_y_axis(game);
+        if(p.jumping && p.jumpTime >= PLAYER_JUMP_DURATION) p.jumping = false;
+        if(p.jumping) {
+            for(int i = 0; i < n; i++) p.jumpTime += dt;
+        }
+        if(p.dashing && !p.huggingWall) {
+            for(int i = 0; i < n; i++) p.dashTime += dt;
+        } else if(!p.dashing && (held.right || held.left)) {
+            p.dir = held.right ? PLAYER_DIR_RIGHT : PLAYER_DIR_LEFT;
+        }
+        p.isOnFloor = false;
+        tick += n;
+    }
 
+    arc->ticks = tick;
+    arc->end = p;
+
+    // each piece goes one way, the highest point is at the end of one
+    arc->apexTick = 0;
+    arc->apex = player->pos;
+    for(int i = 0; i < arc->yCount; i++) {
+        const PlayerArcPiece *piece = &arc->y[i];
+        float y = piece_at(piece, dt, piece->start + piece->count);
+        if(y < arc->apex.y) {
+            arc->apexTick = piece->start + piece->count;
+            arc->apex = (Vector2){ 0, y };
+        }
+    }
+    arc->apex.x = player_arc_at(arc, arc->apexTick).x;
+}
+
+static float axis_at(const PlayerArcPiece *pieces, int count, float dt, int tick, float start) {
+    if(count == 0) return start;
+    for(int i = 0; i < count; i++) {
+        if(tick <= pieces[i].start + pieces[i].count) return piece_at(&pieces[i], dt, MAX(tick, pieces[i].start));
+    }
+    const PlayerArcPiece *last = &pieces[count - 1];
+    return piece_at(last, dt, last->start + last->count);
+}
+
+Vector2 player_arc_at(const PlayerArc *arc, int tick) {
+    return (Vector2) {
+        axis_at(arc->x, arc->xCount, arc->dt, tick, arc->end.pos.x),
+        axis_at(arc->y, arc->yCount, arc->dt, tick, arc->end.pos.y),
+    };
+}
+
+// The ticks in [lo, hi] where a box of the size starting on a piece overlaps
+// (min, max), compared like the collision code does. The piece only goes one
+// way, so that's a range and its ends are binary searched.
+static bool piece_overlaps(const PlayerArcPiece *piece, float dt, int lo, int hi, float size, float min, float max,
+                           int *first, int *last) {
+    bool up = piece_at(piece, dt, hi) >= piece_at(piece, dt, lo);
+
+    int a = lo, b = hi + 1;
+    while(a < b) {
+        int mid = (a + b)/2;
+        float v = piece_at(piece, dt, mid);
+        if(up ? v + size > min : v < max) b = mid;
+        else a = mid + 1;
+    }
+    *first = a;
+
+    a = lo, b = hi + 1;
+    while(a < b) {
+        int mid = (a + b)/2;
+        float v = piece_at(piece, dt, mid);
+        if(up ? !(v < max) : !(v + size > min)) b = mid;
+        else a = mid + 1;
+    }
+    *last = a - 1;
+
+    return *first <= *last;
+}
+
+static bool box_overlaps(Collider c, float x, float y) {
+    return x < c.x + c.width && x + PLAYER_WIDTH > c.x && y < c.y + c.height && y + PLAYER_HEIGHT > c.y;
+}
+
+// The ticks (from, to] are in one piece of each axis. Every candidate is
+// touched during a range of them, by the box moved on x at the height of the
+// tick before (a wall) or by the box moved on both axes.
+static bool arc_chunk_hit(const PlayerArc *arc, const PlayerArcPiece *px, const PlayerArcPiece *py, int from, int to,
+                          const CollisionWorld *world, PlayerArcHit *hit) {
+    float dt = arc->dt;
+    float x0 = piece_at(px, dt, from), x1 = piece_at(px, dt, to);
+    float y0 = piece_at(py, dt, from), y1 = piece_at(py, dt, to);
+    Rectangle area = {
+        .x = fminf(x0, x1),
+        .y = fminf(y0, y1),
+        .width = fabsf(x1 - x0) + PLAYER_WIDTH,
+        .height = fabsf(y1 - y0) + PLAYER_HEIGHT,
+    };
+
+    Collider cands[PLAYER_MAX_CANDIDATES];
+    size_t count = collision_query(world, area, PLAYER_FILTER, cands, NULL, PLAYER_MAX_CANDIDATES);
+
+    int tick = to + 1;
+    for(size_t i = 0; i < count; i++) {
+        Collider c = cands[i];
+        int xa, xb, ya, yb;
+        if(!piece_overlaps(px, dt, from + 1, to, PLAYER_WIDTH, c.x, c.x + c.width, &xa, &xb)) continue;
+
+        if(piece_overlaps(py, dt, from, to - 1, PLAYER_HEIGHT, c.y, c.y + c.height, &ya, &yb) &&
+           MAX(xa, ya + 1) <= MIN(xb, yb + 1)) {
+            tick = MIN(tick, MAX(xa, ya + 1));
+        }
+        if(piece_overlaps(py, dt, from + 1, to, PLAYER_HEIGHT, c.y, c.y + c.height, &ya, &yb) &&
+           MAX(xa, ya) <= MIN(xb, yb)) {
+            tick = MIN(tick, MAX(xa, ya));
+        }
+    }
+    if(tick > to) return false;
+
+    float x = piece_at(px, dt, tick), y = piece_at(py, dt, tick), oldY = piece_at(py, dt, tick - 1);
+    float vx = px->vel + (tick - px->start)*px->accel;
+    float vy = py->vel + (tick - py->start)*py->accel;
+    hit->tick = tick;
+
+    // x is resolved first, like player_step
+    for(size_t i = 0; i < count; i++) {
+        Collider c = cands[i];
+        if(!box_overlaps(c, x, oldY)) continue;
+        hit->type = PLAYER_ARC_WALL;
+        hit->pos = (Vector2){ vx > 0 ? c.x - PLAYER_WIDTH : c.x + c.width, y };
+        hit->collider = c;
+        return true;
+    }
+
+    // the highest floor or the lowest ceiling of the ones overlapped
+    hit->type = vy > 0 ? PLAYER_ARC_LAND : PLAYER_ARC_CEILING;
+    bool found = false;
+    for(size_t i = 0; i < count; i++) {
+        Collider c = cands[i];
+        if(!box_overlaps(c, x, y)) continue;
+        bool better = vy > 0 ? c.y < hit->collider.y : c.y + c.height > hit->collider.y + hit->collider.height;
+        if(found && !better) continue;
+        found = true;
+        hit->collider = c;
+        hit->pos = (Vector2){ x, vy > 0 ? c.y - PLAYER_HEIGHT : c.y + c.height };
+    }
+    return found;
+}
+
+bool player_arc_hit(const PlayerArc *arc, const CollisionWorld *world, PlayerArcHit *hit) {
+    int ix = 0, iy = 0;
+    for(int tick = 0; tick < arc->ticks;) {
+        while(arc->x[ix].start + arc->x[ix].count <= tick) ix++;
+        while(arc->y[iy].start + arc->y[iy].count <= tick) iy++;
+        const PlayerArcPiece *px = &arc->x[ix], *py = &arc->y[iy];
+
+        int end = MIN(px->start + px->count, py->start + py->count);
+        end = MIN(end, tick + PLAYER_ARC_CHUNK);
+        if(arc_chunk_hit(arc, px, py, tick, end, world, hit)) return true;
+        tick = end;
+    }
+    return false;
+}
+
+void player_draw(const Player *player) {
     Rectangle rec = {player->pos.x, player->pos.y, PLAYER_WIDTH, PLAYER_HEIGHT};
     DrawRectangleLinesEx(rec, 2, RED);
 }
+
+static const ParticleEmitter DASH_BURST = {
+    .velocitySpread = { 150, 150 },
+    .offsetSpread = { 10, PLAYER_HEIGHT/2 },
+    .life = 0.3f,
+    .lifeSpread = 0.1f,
+    .size = 6,
+    .color = SKYBLUE,
+};
+
+static const ParticleEmitter DASH_TRAIL = {
+    .velocitySpread = { 40, 40 },
+    .offsetSpread = { PLAYER_WIDTH/2, PLAYER_HEIGHT/2 },
+    .life = 0.25f,
+    .lifeSpread = 0.05f,
+    .size = 4,
+    .color = SKYBLUE,
+};
+
+static const ParticleEmitter LANDING_DUST = {
+    .velocity = { 0, -60 },
+    .velocitySpread = { 250, 60 },
+    .offsetSpread = { PLAYER_WIDTH/2, 2 },
+    .life = 0.4f,
+    .lifeSpread = 0.15f,
+    .size = 5,
+    .color = LIGHTGRAY,
+};
+
+static void emit_effects(ParticleSystem *ps, const Player *player) {
+    Vector2 center = { player->pos.x + PLAYER_WIDTH/2, player->pos.y + PLAYER_HEIGHT/2 };
+    Vector2 feet = { center.x, player->pos.y + PLAYER_HEIGHT };
+
+    if(player->dashStarted) {
+        ParticleEmitter burst = DASH_BURST;
+        burst.velocity = (Vector2){ -300.0f*player->dir, 0 };
+        particles_emit(ps, &burst, center, 32);
+    }
+    if(player->dashing) particles_emit(ps, &DASH_TRAIL, center, 8);
+    if(player->landed) particles_emit(ps, &LANDING_DUST, feet, 24);
+}
+
+void player_update(Game *game) {
+    player_step(&game->player, &game->collision, player_input_from_keyboard(), GetFrameTime());
+    emit_effects(&game->particles, &game->player);
+    player_draw(&game->player);
+}
@@ -4,6 +4,97 @@
 #include "raylib.h"
 #include "game.h"
 
+#define PLAYER_GRAVITY 3000 // the force in which the player is pulled down
+#define PLAYER_MAX_FALL_VELOCITY 4000 // max vertical speed caused by gravity
+#define PLAYER_FALL_VELOCITY_WHEN_HUGGING_WALL 200
+
+#define PLAYER_DASH_SPEED 5000 // the speed of the dash
+#define PLAYER_DASH_DURATION 0.1 // duration of the dash
+
+#define PLAYER_HORIZONTAL_FORCE 7000
+#define PLAYER_MAX_HORIZONTAL_VELOCITY 1000
+
+#define PLAYER_JUMP_FORCE 6500
+#define PLAYER_JUMP_DURATION 0.3
+
+#define PLAYER_WIDTH 60
+#define PLAYER_HEIGHT 120
+
+// What the player wants to do this tick, read from the keyboard by
+// player_update or filled by whoever drives the player without a window.
+typedef struct {
+    bool left;
+    bool right;
+    bool jumpPressed;
+    bool jumpReleased;
+    bool dashPressed;
+} PlayerInput;
+
+PlayerInput player_input_from_keyboard(void);
+
+// Advances the simulation of the player without touching the window
+void player_step(Player *player, const CollisionWorld *world, PlayerInput input, float dt);
+// One tick of the same forces with nothing in the way, the player is in the air after it
+void player_step_free(Player *player, PlayerInput input, float dt);
+
+#define PLAYER_ARC_MAX_PIECES 16
+
+// Ticks (start, start + count] of one axis where the velocity changes by the
+// same amount every tick: j ticks in it's vel + j*accel and the position is
+// pos + dt*(j*vel + accel*j*(j + 1)/2), the sum the ticks would add up.
+typedef struct {
+    int start;
+    int count;
+    float pos;
+    float vel;
+    float accel;
+} PlayerArcPiece;
+
+// Where player_step_free takes the player over the next ticks, solved as a
+// few pieces per axis instead of stepped. Each piece only goes one way, so
+// the apex and the contacts come from the ends of the pieces.
+//
+// It's a hybrid: the ticks that don't follow a line are still stepped with
+// player_step_free, a tick each. Those are the first one (the presses),
+// the one ending a dash, and the one where slowing down snaps to 0.
+typedef struct {
+    PlayerArcPiece x[PLAYER_ARC_MAX_PIECES];
+    PlayerArcPiece y[PLAYER_ARC_MAX_PIECES];
+    int xCount;
+    int yCount;
+    int ticks;
+    float dt;
+
+    Vector2 apex; // the highest position, the start when the player only goes down
+    int apexTick;
+    Player end; // after the last tick, to go on with other inputs
+} PlayerArc;
+
+typedef enum {
+    PLAYER_ARC_LAND,
+    PLAYER_ARC_WALL,
+    PLAYER_ARC_CEILING,
+} PlayerArcHitType;
+
+typedef struct {
+    PlayerArcHitType type;
+    int tick; // the contact happens during this tick, the first one is 1
+    Vector2 pos; // once pushed out of the collider like player_step does
+    Collider collider;
+} PlayerArcHit;
+
+// The arc of the next ticks holding the same input, the press and release
+// events only count on the first tick. A player on the floor that doesn't
+// jump or dash lands on the first tick.
+void player_arc(const Player *player, PlayerInput input, float dt, int ticks, PlayerArc *arc);
+// Position after tick ticks of the arc, 0 is the start
+Vector2 player_arc_at(const PlayerArc *arc, int tick);
+// The first contact of the player box with the solid colliders of the world
+// along the arc, false when there's none
+bool player_arc_hit(const PlayerArc *arc, const CollisionWorld *world, PlayerArcHit *hit);
+void player_draw(const Player *player);
+Rectangle player_get_rec(const Player *player);
+
 void player_update(Game *game);
 
 #endif // PLAYER_H
@@ -0,0 +1,107 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "pool.h"
+
+#define POOL_GENERATION_MASK ((1u << (32 - POOL_SLOT_BITS)) - 1)
+
+static PoolHandle make_handle(const Pool *pool, uint32_t slot) {
+    return (uint32_t)pool->generation[slot] << POOL_SLOT_BITS | slot;
+}
+
+// The position of the object of handle, or count when it's stale
+static uint32_t resolve(const Pool *pool, PoolHandle handle) {
+    uint32_t slot = handle & POOL_SLOT_MASK;
+    if(slot >= pool->capacity) return pool->count;
+    if(pool->generation[slot] != handle >> POOL_SLOT_BITS) return pool->count;
+
+    // a free slot keeps its generation until it's reused, the position of a
+    // free one is the next in the list and points past the live objects
+    uint32_t i = pool->position[slot];
+    if(i >= pool->count || pool->slotOf[i] != slot) return pool->count;
+    return i;
+}
+
+void pool_init(Pool *pool, size_t itemSize, uint32_t capacity, MemTag tag) {
+    assert(capacity <= POOL_MAX_CAPACITY);
+
+    *pool = (Pool) {
+        .itemSize = itemSize,
+        .capacity = capacity,
+    };
+
+    if(capacity == 0) return;
+    pool->items = mem_alloc(tag, (size_t)capacity*itemSize);
+    pool->slotOf = mem_alloc(tag, capacity*sizeof(uint32_t));
+    pool->position = mem_alloc(tag, capacity*sizeof(uint32_t));
+    pool->generation = mem_calloc(tag, capacity, sizeof(uint16_t));
+    assert(pool->items != NULL && pool->slotOf != NULL && pool->position != NULL &&
+           pool->generation != NULL && "No enough ram");
+
+    // every slot free, in order
+    for(uint32_t s = 0; s < capacity; s++) pool->position[s] = s + 1;
+    pool->freeSlot = 0;
+}
+
+void pool_free(Pool *pool) {
+    mem_free(pool->items);
+    mem_free(pool->slotOf);
+    mem_free(pool->position);
+    mem_free(pool->generation);
+    *pool = (Pool){0};
+}
+
+PoolHandle pool_alloc(Pool *pool) {
+    if(pool->count == pool->capacity) return POOL_HANDLE_NONE;
+
+    uint32_t slot = pool->freeSlot;
+    pool->freeSlot = pool->position[slot];
+
+    uint32_t i = pool->count++;
+    pool->slotOf[i] = slot;
+    pool->position[slot] = i;
+    memset(pool->items + (size_t)i*pool->itemSize, 0, pool->itemSize);
+    return make_handle(pool, slot);
+}
+
+bool pool_release(Pool *pool, PoolHandle handle) {
+    uint32_t i = resolve(pool, handle);
+    if(i == pool->count) return false;
+
+    // the last object fills the hole
+    uint32_t slot = handle & POOL_SLOT_MASK;
+    uint32_t last = --pool->count;
+    if(i != last) {
+        memcpy(pool->items + (size_t)i*pool->itemSize, pool->items + (size_t)last*pool->itemSize, pool->itemSize);
+        pool->slotOf[i] = pool->slotOf[last];
+        pool->position[pool->slotOf[i]] = i;
+    }
+
+    // the generation wraps, a handle kept through 4096 reuses of its slot
+    // would resolve again
+    pool->generation[slot] = (pool->generation[slot] + 1) & POOL_GENERATION_MASK;
+    pool->position[slot] = pool->freeSlot;
+    pool->freeSlot = slot;
+    return true;
+}
+
+void *pool_get(const Pool *pool, PoolHandle handle) {
+    uint32_t i = resolve(pool, handle);
+    if(i == pool->count) return NULL;
+    return pool->items + (size_t)i*pool->itemSize;
+}
+
+bool pool_alive(const Pool *pool, PoolHandle handle) {
+    return resolve(pool, handle) != pool->count;
+}
+
+void *pool_at(const Pool *pool, uint32_t i) {
+    assert(i < pool->count);
+    return pool->items + (size_t)i*pool->itemSize;
+}
+
+PoolHandle pool_handle_at(const Pool *pool, uint32_t i) {
+    assert(i < pool->count);
+    return make_handle(pool, pool->slotOf[i]);
+}
@@ -0,0 +1,54 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mem.h"
+
+// A handle is the slot in the low bits and the generation of the slot in the
+// high ones. Freeing a slot bumps its generation, so handles to what used to
+// be there stop resolving instead of pointing at whatever came next.
+typedef uint32_t PoolHandle;
+
+#define POOL_SLOT_BITS 20
+#define POOL_SLOT_MASK ((1u << POOL_SLOT_BITS) - 1)
+#define POOL_MAX_CAPACITY POOL_SLOT_MASK // the last slot would be POOL_HANDLE_NONE
+#define POOL_HANDLE_NONE 0xffffffffu
+
+// Fixed capacity storage for things spawned and despawned all the time. The
+// objects are kept packed in items, a free swaps the last one into the hole,
+// so iterating is a loop over items[0..count]. Handles go through the slots
+// to find where their object is now. Everything is allocated by pool_init,
+// alloc and free never touch the heap.
+typedef struct {
+    unsigned char *items; // count objects of itemSize bytes, packed
+    size_t itemSize;
+    uint32_t count;
+    uint32_t capacity;
+
+    uint32_t *slotOf; // slot of the object at each position
+    uint32_t *position; // position of the object of each slot, next free slot when free
+    uint16_t *generation;
+    uint32_t freeSlot;
+} Pool;
+
+// The whole capacity is allocated here and counted in tag
+void pool_init(Pool *pool, size_t itemSize, uint32_t capacity, MemTag tag);
+void pool_free(Pool *pool);
+
+// Returns a handle to a zeroed object, POOL_HANDLE_NONE when the pool is full
+PoolHandle pool_alloc(Pool *pool);
+// Returns false when the handle is stale, nothing is freed then
+bool pool_release(Pool *pool, PoolHandle handle);
+
+// NULL when the handle is stale. The pointer is valid until the next free,
+// which may move the object.
+void *pool_get(const Pool *pool, PoolHandle handle);
+bool pool_alive(const Pool *pool, PoolHandle handle);
+
+// The live objects in order, i < count
+void *pool_at(const Pool *pool, uint32_t i);
+PoolHandle pool_handle_at(const Pool *pool, uint32_t i);
+
+#endif // POOL_H
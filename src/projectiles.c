@@ -0,0 +1,340 @@
+#include <math.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "projectiles.h"
+#include "mem.h"
+#include "rlgl.h"
+
+static const CollisionFilter PROJECTILE_FILTER = {
+    .category = COLLISION_LAYER_PROJECTILE,
+    .mask = COLLISION_LAYER_SOLID,
+};
+
+// zeroed, the padding lanes are integrated too and must hold numbers
+static bool alloc_lanes(Projectiles *p, size_t capacity) {
+    p->x = mem_calloc(MEM_TAG_PHYSICS, capacity, sizeof(float));
+    p->y = mem_calloc(MEM_TAG_PHYSICS, capacity, sizeof(float));
+    p->vx = mem_calloc(MEM_TAG_PHYSICS, capacity, sizeof(float));
+    p->vy = mem_calloc(MEM_TAG_PHYSICS, capacity, sizeof(float));
+    p->life = mem_calloc(MEM_TAG_PHYSICS, capacity, sizeof(float));
+    p->radius = mem_calloc(MEM_TAG_PHYSICS, capacity, sizeof(float));
+    p->cellItems = mem_calloc(MEM_TAG_PHYSICS, capacity, sizeof(uint32_t));
+    p->cellOf = mem_calloc(MEM_TAG_PHYSICS, capacity, sizeof(uint16_t));
+    p->capacity = capacity;
+    if(p->x != NULL && p->y != NULL && p->vx != NULL && p->vy != NULL && p->life != NULL &&
+       p->radius != NULL && p->cellItems != NULL && p->cellOf != NULL) {
+        return true;
+    }
+
+    mem_free(p->x);
+    mem_free(p->y);
+    mem_free(p->vx);
+    mem_free(p->vy);
+    mem_free(p->life);
+    mem_free(p->radius);
+    mem_free(p->cellItems);
+    mem_free(p->cellOf);
+    p->x = p->y = p->vx = p->vy = p->life = p->radius = NULL;
+    p->cellItems = NULL;
+    p->cellOf = NULL;
+    p->capacity = 0;
+    return false;
+}
+
+void projectiles_init(Projectiles *p, size_t capacity) {
+    *p = (Projectiles){0};
+    // the emitters first, they are small and the lanes take what is left
+    pool_init(&p->emitters, sizeof(ProjectileEmitter), PROJECTILE_MAX_EMITTERS, MEM_TAG_PHYSICS);
+
+    // over the physics budget it tries with half the lanes, down to none.
+    // The spawns that don't fit are counted in dropped.
+    capacity = (capacity + 3) & ~(size_t)3;
+    while(capacity > 0 && !alloc_lanes(p, capacity)) {
+        capacity = (capacity/2) & ~(size_t)3;
+    }
+}
+
+void projectiles_free(Projectiles *p) {
+    mem_free(p->x);
+    mem_free(p->y);
+    mem_free(p->vx);
+    mem_free(p->vy);
+    mem_free(p->life);
+    mem_free(p->radius);
+    mem_free(p->cellItems);
+    mem_free(p->cellOf);
+    pool_free(&p->emitters);
+    *p = (Projectiles){0};
+}
+
+PoolHandle projectiles_add_emitter(Projectiles *p, ProjectileEmitter emitter) {
+    PoolHandle handle = pool_alloc(&p->emitters);
+    if(handle != POOL_HANDLE_NONE) *(ProjectileEmitter*)pool_get(&p->emitters, handle) = emitter;
+    return handle;
+}
+
+bool projectiles_remove_emitter(Projectiles *p, PoolHandle emitter) {
+    return pool_release(&p->emitters, emitter);
+}
+
+void projectiles_spawn(Projectiles *p, Vector2 pos, Vector2 vel, float life, float radius) {
+    if(p->count == p->capacity) {
+        p->dropped++;
+        return;
+    }
+
+    size_t i = p->count++;
+    p->x[i] = pos.x;
+    p->y[i] = pos.y;
+    p->vx[i] = vel.x;
+    p->vy[i] = vel.y;
+    p->life[i] = life;
+    p->radius[i] = fminf(radius, PROJECTILE_MAX_RADIUS);
+}
+
+void projectiles_shift(Projectiles *p, Vector2 delta) {
+    for(size_t i = 0; i < p->count; i++) {
+        p->x[i] += delta.x;
+        p->y[i] += delta.y;
+    }
+    for(uint32_t e = 0; e < p->emitters.count; e++) {
+        ProjectileEmitter *em = pool_at(&p->emitters, e);
+        em->pos.x += delta.x;
+        em->pos.y += delta.y;
+    }
+}
+
+static void fire_emitters(Projectiles *p, float dt) {
+    for(uint32_t e = 0; e < p->emitters.count; e++) {
+        ProjectileEmitter *em = pool_at(&p->emitters, e);
+        if(em->rate <= 0 || em->arms <= 0) continue;
+
+        em->timer -= dt;
+        while(em->timer <= 0) {
+            for(int a = 0; a < em->arms; a++) {
+                float angle = em->angle + 2*PI*a/em->arms;
+                Vector2 vel = { cosf(angle)*em->speed, sinf(angle)*em->speed };
+                projectiles_spawn(p, em->pos, vel, em->life, em->radius);
+            }
+            em->timer += 1/em->rate;
+        }
+        em->angle = fmodf(em->angle + em->spin*dt, 2*PI);
+    }
+}
+
+// groups of 4 projectiles per job
+#define PROJECTILE_GRAIN 1024
+
+// Moves the projectiles [begin, end) and finds the cell of each one in the
+// same pass. Both are multiples of 4 and so is the capacity, the last group
+// runs over the padding.
+static void integrate_and_bin(Projectiles *p, size_t begin, size_t end, float dt) {
+    float invCell = 1.0f/PROJECTILE_CELL_SIZE;
+
+#ifdef __SSE2__
+    __m128 vdt = _mm_set1_ps(dt);
+    __m128 vInvCell = _mm_set1_ps(invCell);
+    __m128 gx = _mm_set1_ps(p->gridX), gy = _mm_set1_ps(p->gridY);
+    __m128 zero = _mm_setzero_ps(), dim = _mm_set1_ps(PROJECTILE_GRID_DIM);
+    __m128i outside = _mm_set1_epi32(PROJECTILE_GRID_CELLS);
+    for(size_t i = begin; i < end; i += 4) {
+        __m128 x = _mm_add_ps(_mm_loadu_ps(p->x + i), _mm_mul_ps(_mm_loadu_ps(p->vx + i), vdt));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(p->y + i), _mm_mul_ps(_mm_loadu_ps(p->vy + i), vdt));
+        __m128 life = _mm_sub_ps(_mm_loadu_ps(p->life + i), vdt);
+        _mm_storeu_ps(p->x + i, x);
+        _mm_storeu_ps(p->y + i, y);
+        _mm_storeu_ps(p->life + i, life);
+
+        __m128 fx = _mm_mul_ps(_mm_sub_ps(x, gx), vInvCell);
+        __m128 fy = _mm_mul_ps(_mm_sub_ps(y, gy), vInvCell);
+        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(fx, zero), _mm_cmplt_ps(fx, dim)),
+                                   _mm_and_ps(_mm_cmpge_ps(fy, zero), _mm_cmplt_ps(fy, dim)));
+        inside = _mm_and_ps(inside, _mm_cmpgt_ps(life, zero));
+
+        // the cells of the lanes outside are garbage and get replaced
+        __m128i cell = _mm_add_epi32(_mm_cvttps_epi32(fx),
+                                     _mm_slli_epi32(_mm_cvttps_epi32(fy), PROJECTILE_GRID_SHIFT));
+        __m128i keep = _mm_castps_si128(inside);
+        cell = _mm_or_si128(_mm_and_si128(keep, cell), _mm_andnot_si128(keep, outside));
+        _mm_storel_epi64((__m128i*)(p->cellOf + i), _mm_packs_epi32(cell, cell));
+    }
+#else
+    for(size_t i = begin; i < end; i++) {
+        p->x[i] += p->vx[i]*dt;
+        p->y[i] += p->vy[i]*dt;
+        p->life[i] -= dt;
+
+        float fx = (p->x[i] - p->gridX)*invCell;
+        float fy = (p->y[i] - p->gridY)*invCell;
+        bool inside = fx >= 0 && fx < PROJECTILE_GRID_DIM && fy >= 0 && fy < PROJECTILE_GRID_DIM && p->life[i] > 0;
+        p->cellOf[i] = inside ? (int)fy*PROJECTILE_GRID_DIM + (int)fx : PROJECTILE_GRID_CELLS;
+    }
+#endif
+}
+
+typedef struct {
+    Projectiles *p;
+    float dt;
+} IntegrateJob;
+
+static void integrate_groups(void *data, size_t begin, size_t end) {
+    IntegrateJob *job = data;
+    integrate_and_bin(job->p, begin*4, end*4, job->dt);
+}
+
+// Counting sort of the projectiles by cell, like the static index builds its CSR
+static void sort_cells(Projectiles *p) {
+    uint32_t *start = p->cellStart;
+    memset(start, 0, sizeof(p->cellStart));
+    for(size_t i = 0; i < p->count; i++) {
+        if(p->cellOf[i] < PROJECTILE_GRID_CELLS) start[p->cellOf[i] + 1]++;
+    }
+    for(int c = 0; c < PROJECTILE_GRID_CELLS; c++) start[c + 1] += start[c];
+
+    // start[c] is used as the write cursor of c and shifted back after
+    for(size_t i = 0; i < p->count; i++) {
+        if(p->cellOf[i] < PROJECTILE_GRID_CELLS) p->cellItems[start[p->cellOf[i]]++] = i;
+    }
+    for(int c = PROJECTILE_GRID_CELLS; c > 0; c--) start[c] = start[c - 1];
+    start[0] = 0;
+}
+
+static void push_hit(Projectiles *p, ProjectileHitType type, size_t i, ColliderRef collider) {
+    p->life[i] = 0;
+    if(p->hitCount == PROJECTILE_MAX_HITS) {
+        p->droppedHits++;
+        return;
+    }
+
+    p->hits[p->hitCount++] = (ProjectileHit) {
+        .type = type,
+        .pos = { p->x[i], p->y[i] },
+        .collider = collider,
+    };
+}
+
+static int grid_coord(float value, float origin) {
+    int c = (int)floorf((value - origin)/PROJECTILE_CELL_SIZE);
+    if(c < 0) return 0;
+    if(c >= PROJECTILE_GRID_DIM) return PROJECTILE_GRID_DIM - 1;
+    return c;
+}
+
+// Tests box against the projectiles binned in the cells it covers. They are
+// binned by their center, so the box is grown by the biggest radius.
+static void hit_box(Projectiles *p, Rectangle box, ProjectileHitType type, ColliderRef collider) {
+    float gridMax = PROJECTILE_GRID_DIM*PROJECTILE_CELL_SIZE;
+    if(box.x - PROJECTILE_MAX_RADIUS >= p->gridX + gridMax || box.x + box.width + PROJECTILE_MAX_RADIUS < p->gridX ||
+       box.y - PROJECTILE_MAX_RADIUS >= p->gridY + gridMax || box.y + box.height + PROJECTILE_MAX_RADIUS < p->gridY) {
+        return;
+    }
+
+    int x0 = grid_coord(box.x - PROJECTILE_MAX_RADIUS, p->gridX);
+    int x1 = grid_coord(box.x + box.width + PROJECTILE_MAX_RADIUS, p->gridX);
+    int y0 = grid_coord(box.y - PROJECTILE_MAX_RADIUS, p->gridY);
+    int y1 = grid_coord(box.y + box.height + PROJECTILE_MAX_RADIUS, p->gridY);
+
+    for(int cy = y0; cy <= y1; cy++) {
+        for(int cx = x0; cx <= x1; cx++) {
+            int c = cy*PROJECTILE_GRID_DIM + cx;
+            for(uint32_t k = p->cellStart[c]; k < p->cellStart[c + 1]; k++) {
+                uint32_t i = p->cellItems[k];
+                float r = p->radius[i];
+                // already gone, the player is tested first and wins
+                if(p->life[i] <= 0) continue;
+                if(p->x[i] - r < box.x + box.width && p->x[i] + r > box.x &&
+                   p->y[i] - r < box.y + box.height && p->y[i] + r > box.y) {
+                    push_hit(p, type, i, collider);
+                }
+            }
+        }
+    }
+}
+
+static void remove_dead(Projectiles *p) {
+    size_t i = 0;
+    while(i < p->count) {
+#ifdef __SSE2__
+        if(i + 4 <= p->count) {
+            __m128 dead = _mm_cmple_ps(_mm_loadu_ps(p->life + i), _mm_setzero_ps());
+            if(_mm_movemask_ps(dead) == 0) {
+                i += 4;
+                continue;
+            }
+        }
+#endif
+        if(p->life[i] > 0) {
+            i++;
+            continue;
+        }
+
+        size_t last = --p->count;
+        p->x[i] = p->x[last];
+        p->y[i] = p->y[last];
+        p->vx[i] = p->vx[last];
+        p->vy[i] = p->vy[last];
+        p->life[i] = p->life[last];
+        p->radius[i] = p->radius[last];
+    }
+}
+
+// Without a job system the integration runs on the caller
+static void update(JobSystem *js, Projectiles *p, const CollisionWorld *world, Rectangle player, float dt) {
+    p->hitCount = 0;
+    p->droppedHits = 0;
+
+    fire_emitters(p, dt);
+
+    float half = PROJECTILE_GRID_DIM*PROJECTILE_CELL_SIZE*0.5f;
+    p->gridX = player.x + player.width*0.5f - half;
+    p->gridY = player.y + player.height*0.5f - half;
+    if(js != NULL) {
+        IntegrateJob job = { .p = p, .dt = dt };
+        jobs_parallel_for(js, (p->count + 3)/4, PROJECTILE_GRAIN, integrate_groups, &job);
+    } else {
+        integrate_and_bin(p, 0, (p->count + 3) & ~(size_t)3, dt);
+    }
+    sort_cells(p);
+
+    hit_box(p, player, PROJECTILE_HIT_PLAYER, COLLIDER_REF_NONE);
+
+    Rectangle area = { p->gridX, p->gridY, 2*half, 2*half };
+    Collider colliders[PROJECTILE_MAX_COLLIDERS];
+    ColliderRef refs[PROJECTILE_MAX_COLLIDERS];
+    size_t count = collision_query(world, area, PROJECTILE_FILTER, colliders, refs, PROJECTILE_MAX_COLLIDERS);
+    for(size_t c = 0; c < count; c++) {
+        Rectangle box = { colliders[c].x, colliders[c].y, colliders[c].width, colliders[c].height };
+        hit_box(p, box, PROJECTILE_HIT_LEVEL, refs[c]);
+    }
+
+    remove_dead(p);
+}
+
+void projectiles_update(Projectiles *p, const CollisionWorld *world, Rectangle player, float dt) {
+    update(NULL, p, world, player, dt);
+}
+
+void projectiles_update_parallel(JobSystem *js, Projectiles *p, const CollisionWorld *world, Rectangle player, float dt) {
+    update(js, p, world, player, dt);
+}
+
+void projectiles_draw(const Projectiles *p) {
+    if(p->count == 0) return;
+
+    rlSetTexture(rlGetTextureIdDefault());
+    rlBegin(RL_QUADS);
+    rlColor4ub(255, 120, 60, 255);
+    for(size_t i = 0; i < p->count; i++) {
+        float x = p->x[i], y = p->y[i], r = p->radius[i];
+        rlVertex2f(x - r, y - r);
+        rlVertex2f(x - r, y + r);
+        rlVertex2f(x + r, y + r);
+        rlVertex2f(x + r, y - r);
+    }
+    rlEnd();
+    rlSetTexture(0);
+}
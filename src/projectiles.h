@@ -0,0 +1,100 @@
+#ifndef PROJECTILES_H
+#define PROJECTILES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "raylib.h"
+#include "collision.h"
+#include "jobs.h"
+#include "pool.h"
+
+#define PROJECTILE_MAX_HITS 1024 // per tick, the rest are counted as dropped
+#define PROJECTILE_MAX_RADIUS 32
+#define PROJECTILE_MAX_COLLIDERS 1024 // level colliders tested per tick
+#define PROJECTILE_MAX_EMITTERS 256
+
+// Only the projectiles in a square around the player are binned and tested,
+// the others just fly until their life runs out
+#define PROJECTILE_CELL_SIZE 64
+#define PROJECTILE_GRID_SHIFT 5
+#define PROJECTILE_GRID_DIM (1 << PROJECTILE_GRID_SHIFT) // cells per side, 2048 units around the player
+#define PROJECTILE_GRID_CELLS (PROJECTILE_GRID_DIM*PROJECTILE_GRID_DIM)
+
+// A hazard that fires arms projectiles evenly spread around a turning angle
+typedef struct {
+    Vector2 pos;
+    float rate; // volleys per second
+    int arms;
+    float angle; // radians, of the first arm
+    float spin; // radians per second
+    float speed;
+    float life;
+    float radius;
+
+    float timer; // until the next volley
+} ProjectileEmitter;
+
+typedef enum {
+    PROJECTILE_HIT_PLAYER,
+    PROJECTILE_HIT_LEVEL,
+} ProjectileHitType;
+
+typedef struct {
+    ProjectileHitType type;
+    Vector2 pos; // of the projectile
+    ColliderRef collider; // COLLIDER_REF_NONE for the player
+} ProjectileHit;
+
+// Many small square projectiles stored as SoA. A tick integrates them 4 at a
+// time, bins the ones near the player in a uniform grid with a counting
+// sort, then tests each level collider and the player only against the
+// cells they cover. Projectiles that hit something or run out of life are
+// swap removed, the hits of the tick are queued in a fixed buffer.
+typedef struct {
+    float *x; // center
+    float *y;
+    float *vx;
+    float *vy;
+    float *life;
+    float *radius; // half the side
+    size_t count;
+    size_t capacity; // a multiple of 4, the lanes past count are padding
+
+    Pool emitters; // of ProjectileEmitter, they come and go by handle
+
+    // the grid of the update, only valid until the dead are removed
+    float gridX;
+    float gridY;
+    uint32_t cellStart[PROJECTILE_GRID_CELLS + 1];
+    uint32_t *cellItems;
+    uint16_t *cellOf; // of each projectile, PROJECTILE_GRID_CELLS when outside
+
+    ProjectileHit hits[PROJECTILE_MAX_HITS];
+    size_t hitCount;
+    size_t droppedHits;
+    size_t dropped; // projectiles that didn't fit
+} Projectiles;
+
+// The capacity is smaller, down to 0, when the physics budget refuses the lanes
+void projectiles_init(Projectiles *p, size_t capacity);
+void projectiles_free(Projectiles *p);
+
+// POOL_HANDLE_NONE when there are already PROJECTILE_MAX_EMITTERS
+PoolHandle projectiles_add_emitter(Projectiles *p, ProjectileEmitter emitter);
+// Its projectiles keep flying, false when the handle is stale
+bool projectiles_remove_emitter(Projectiles *p, PoolHandle emitter);
+void projectiles_spawn(Projectiles *p, Vector2 pos, Vector2 vel, float life, float radius);
+void projectiles_shift(Projectiles *p, Vector2 delta);
+
+// Fires the emitters, moves everything and fills hits with what touched the
+// player box or the solid colliders of the world this tick
+void projectiles_update(Projectiles *p, const CollisionWorld *world, Rectangle player, float dt);
+// Same as projectiles_update with the integration and binning split over the
+// job system, the sort and the hit tests stay serial
+void projectiles_update_parallel(JobSystem *js, Projectiles *p, const CollisionWorld *world, Rectangle player, float dt);
+
+// One quad batch for all of them, inside BeginMode2D
+void projectiles_draw(const Projectiles *p);
+
+#endif // PROJECTILES_H
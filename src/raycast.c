@@ -0,0 +1,390 @@
+#include <math.h>
+#include <stdbool.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "raycast.h"
+#include "tilemap.h"
+
+#define RAYCAST_GRAIN 64 // rays per job
+
+// An axis without direction can't go through the slab test (0*inf), the ray
+// is inside that slab for every t or for none.
+typedef struct {
+    float ox;
+    float oy;
+    float invX;
+    float invY;
+    float signX;
+    float signY;
+    bool zeroX;
+    bool zeroY;
+    CollisionFilter filter;
+} PreparedRay;
+
+static void slab1(float origin, float inv, bool zero, float min, float max, float *tNear, float *tFar) {
+    if(zero) {
+        bool inside = min <= origin && origin <= max;
+        *tNear = inside ? -INFINITY : INFINITY;
+        *tFar = inside ? INFINITY : -INFINITY;
+    } else {
+        float t1 = (min - origin)*inv;
+        float t2 = (max - origin)*inv;
+        *tNear = fminf(t1, t2);
+        *tFar = fmaxf(t1, t2);
+    }
+}
+
+#ifdef __SSE2__
+static void slab1_sse(float origin, float inv, bool zero, __m128 min, __m128 max, __m128 *tNear, __m128 *tFar) {
+    __m128 o = _mm_set1_ps(origin);
+    if(zero) {
+        __m128 inside = _mm_and_ps(_mm_cmple_ps(min, o), _mm_cmple_ps(o, max));
+        __m128 inf = _mm_set1_ps(INFINITY);
+        __m128 negInf = _mm_set1_ps(-INFINITY);
+        *tNear = _mm_or_ps(_mm_and_ps(inside, negInf), _mm_andnot_ps(inside, inf));
+        *tFar = _mm_or_ps(_mm_and_ps(inside, inf), _mm_andnot_ps(inside, negInf));
+    } else {
+        __m128 v = _mm_set1_ps(inv);
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(min, o), v);
+        __m128 t2 = _mm_mul_ps(_mm_sub_ps(max, o), v);
+        *tNear = _mm_min_ps(t1, t2);
+        *tFar = _mm_max_ps(t1, t2);
+    }
+}
+#endif
+
+// Slab test of one ray against 4 boxes. tNear > tFar means a miss, xFace
+// tells if tNear is on a vertical side.
+static void slab4(const PreparedRay *r, const float *minX, const float *minY, const float *maxX, const float *maxY,
+                  float *tNear, float *tFar, int *xFace) {
+#ifdef __SSE2__
+    __m128 txNear, txFar, tyNear, tyFar;
+    slab1_sse(r->ox, r->invX, r->zeroX, _mm_loadu_ps(minX), _mm_loadu_ps(maxX), &txNear, &txFar);
+    slab1_sse(r->oy, r->invY, r->zeroY, _mm_loadu_ps(minY), _mm_loadu_ps(maxY), &tyNear, &tyFar);
+
+    _mm_storeu_ps(tNear, _mm_max_ps(txNear, tyNear));
+    _mm_storeu_ps(tFar, _mm_min_ps(txFar, tyFar));
+    int mask = _mm_movemask_ps(_mm_cmpge_ps(txNear, tyNear));
+    for(int j = 0; j < 4; j++) xFace[j] = mask >> j & 1;
+#else
+    for(int j = 0; j < 4; j++) {
+        float txNear, txFar, tyNear, tyFar;
+        slab1(r->ox, r->invX, r->zeroX, minX[j], maxX[j], &txNear, &txFar);
+        slab1(r->oy, r->invY, r->zeroY, minY[j], maxY[j], &tyNear, &tyFar);
+
+        tNear[j] = fmaxf(txNear, tyNear);
+        tFar[j] = fminf(txFar, tyFar);
+        xFace[j] = txNear >= tyNear;
+    }
+#endif
+}
+
+static void test_boxes(const PreparedRay *r, const float *minX, const float *minY, const float *maxX, const float *maxY,
+                       const ColliderRef *refs, int count, RayHit *best) {
+    float tNear[4], tFar[4];
+    int xFace[4];
+    slab4(r, minX, minY, maxX, maxY, tNear, tFar, xFace);
+
+    for(int j = 0; j < count; j++) {
+        float t = fmaxf(tNear[j], 0);
+        if(tFar[j] < t || t >= best->distance) continue;
+
+        best->distance = t;
+        best->collider = refs[j];
+        if(tNear[j] < 0) {
+            best->normal = (Vector2){ 0, 0 };
+        } else if(xFace[j]) {
+            best->normal = (Vector2){ -r->signX, 0 };
+        } else {
+            best->normal = (Vector2){ 0, -r->signY };
+        }
+    }
+}
+
+// The layers are checked while the lanes are filled, so rejected colliders
+// never reach the slab test
+static void test_cell(const PreparedRay *r, const StaticIndex *index, const StaticGrid *grid, size_t cell, RayHit *best) {
+    float minX[4], minY[4], maxX[4], maxY[4];
+    ColliderRef refs[4];
+    int lanes = 0;
+
+    for(uint32_t k = grid->cellStart[cell]; k < grid->cellStart[cell + 1]; k++) {
+        uint32_t i = grid->cellItems[k];
+        if(!collision_filter_accepts(r->filter, index->category[i], index->mask[i])) continue;
+
+        minX[lanes] = index->minX[i];
+        minY[lanes] = index->minY[i];
+        maxX[lanes] = index->maxX[i];
+        maxY[lanes] = index->maxY[i];
+        refs[lanes] = i;
+
+        if(++lanes == 4) {
+            test_boxes(r, minX, minY, maxX, maxY, refs, 4, best);
+            lanes = 0;
+        }
+    }
+
+    if(lanes > 0) {
+        // the unused lanes repeat the last item
+        for(int j = lanes; j < 4; j++) {
+            minX[j] = minX[lanes - 1];
+            minY[j] = minY[lanes - 1];
+            maxX[j] = maxX[lanes - 1];
+            maxY[j] = maxY[lanes - 1];
+        }
+        test_boxes(r, minX, minY, maxX, maxY, refs, lanes, best);
+    }
+}
+
+// Walks the cells of a level crossed by the ray, in order, and stops as soon
+// as the closest hit is inside the cells already visited.
+static void cast_grid(const PreparedRay *r, float dirX, float dirY, const StaticIndex *index, const StaticGrid *grid,
+                      RayHit *best) {
+    float cs = grid->cellSize;
+    float gridMinX = index->originX, gridMinY = index->originY;
+    float gridMaxX = gridMinX + grid->cols*cs, gridMaxY = gridMinY + grid->rows*cs;
+
+    float txNear, txFar, tyNear, tyFar;
+    slab1(r->ox, r->invX, r->zeroX, gridMinX, gridMaxX, &txNear, &txFar);
+    slab1(r->oy, r->invY, r->zeroY, gridMinY, gridMaxY, &tyNear, &tyFar);
+    float tEnter = fmaxf(fmaxf(txNear, tyNear), 0);
+    float tExit = fminf(fminf(txFar, tyFar), best->distance);
+    if(tEnter > tExit) return;
+
+    float px = r->ox + dirX*tEnter;
+    float py = r->oy + dirY*tEnter;
+    int cx = (int)floorf((px - gridMinX)/cs);
+    int cy = (int)floorf((py - gridMinY)/cs);
+    if(cx < 0) cx = 0;
+    if(cy < 0) cy = 0;
+    if(cx >= grid->cols) cx = grid->cols - 1;
+    if(cy >= grid->rows) cy = grid->rows - 1;
+
+    int stepX = dirX > 0 ? 1 : -1;
+    int stepY = dirY > 0 ? 1 : -1;
+    float tDeltaX = r->zeroX ? INFINITY : fabsf(cs*r->invX);
+    float tDeltaY = r->zeroY ? INFINITY : fabsf(cs*r->invY);
+    float tMaxX = r->zeroX ? INFINITY : (gridMinX + (cx + (stepX > 0))*cs - r->ox)*r->invX;
+    float tMaxY = r->zeroY ? INFINITY : (gridMinY + (cy + (stepY > 0))*cs - r->oy)*r->invY;
+
+    for(;;) {
+        test_cell(r, index, grid, (size_t)cy*grid->cols + cx, best);
+
+        float tCellExit = fminf(tMaxX, tMaxY);
+        if(best->distance <= tCellExit || tCellExit > tExit) break;
+
+        if(tMaxX < tMaxY) {
+            cx += stepX;
+            tMaxX += tDeltaX;
+            if(cx < 0 || cx >= grid->cols) break;
+        } else {
+            cy += stepY;
+            tMaxY += tDeltaY;
+            if(cy < 0 || cy >= grid->rows) break;
+        }
+    }
+}
+
+// Every level is walked on its own, coarsest first. A hit found in one of them
+// shortens the walks of the next ones.
+static void cast_static(const PreparedRay *r, float dirX, float dirY, const StaticIndex *index, RayHit *best) {
+    for(int l = index->levelCount - 1; l >= 0; l--) {
+        cast_grid(r, dirX, dirY, index, &index->levels[l], best);
+    }
+}
+
+static void test_dynamic(const PreparedRay *r, const DynamicIndex *dynamics, uint32_t item, RayHit *best) {
+    Collider c = dynamics->items[item];
+    if(!collision_filter_accepts(r->filter, c.category, c.mask)) return;
+
+    float minX[4] = { c.x, c.x, c.x, c.x };
+    float minY[4] = { c.y, c.y, c.y, c.y };
+    float maxX[4] = { c.x + c.width, c.x + c.width, c.x + c.width, c.x + c.width };
+    float maxY[4] = { c.y + c.height, c.y + c.height, c.y + c.height, c.y + c.height };
+    ColliderRef ref = item | COLLIDER_REF_DYNAMIC;
+    test_boxes(r, minX, minY, maxX, maxY, &ref, 1, best);
+}
+
+// Walks the cells of the hash crossed by the ray like cast_grid. A collider
+// is binned in every cell its fat box touches, so one crossed in several
+// cells is tested again, the hit stays the same. A ray crossing more cells
+// than there are colliders scans them instead, like dynamic_query does.
+static void cast_dynamic(const PreparedRay *r, float dirX, float dirY, const DynamicIndex *dynamics, RayHit *best) {
+    if(dynamics->count == 0) return;
+
+    float cs = DYNAMIC_INDEX_CELL_SIZE;
+    float tExit = best->distance;
+    float cells = (fabsf(dirX) + fabsf(dirY))*tExit/cs + 2;
+    if(!(cells <= dynamics->count)) {
+        for(size_t i = 0; i < dynamics->count; i++) test_dynamic(r, dynamics, i, best);
+        return;
+    }
+
+    // in cells of the world, the hash is offset by the shifts
+    int cx = (int)floorf(r->ox/cs), cy = (int)floorf(r->oy/cs);
+    int stepX = dirX > 0 ? 1 : -1;
+    int stepY = dirY > 0 ? 1 : -1;
+    float tDeltaX = r->zeroX ? INFINITY : fabsf(cs*r->invX);
+    float tDeltaY = r->zeroY ? INFINITY : fabsf(cs*r->invY);
+    float tMaxX = r->zeroX ? INFINITY : ((cx + (stepX > 0))*cs - r->ox)*r->invX;
+    float tMaxY = r->zeroY ? INFINITY : ((cy + (stepY > 0))*cs - r->oy)*r->invY;
+
+    for(;;) {
+        int hx = cx - dynamics->cellOffsetX, hy = cy - dynamics->cellOffsetY;
+        uint32_t node = dynamics->buckets[dynamic_index_bucket(hx, hy)];
+        for(; node != DYNAMIC_INDEX_NODE_NONE; node = dynamics->nodes[node].next) {
+            const DynamicNode *n = &dynamics->nodes[node];
+            if(n->cx == hx && n->cy == hy) test_dynamic(r, dynamics, n->item, best);
+        }
+
+        float tCellExit = fminf(tMaxX, tMaxY);
+        if(best->distance <= tCellExit || tCellExit > tExit) break;
+
+        if(tMaxX < tMaxY) {
+            cx += stepX;
+            tMaxX += tDeltaX;
+        } else {
+            cy += stepY;
+            tMaxY += tDeltaY;
+        }
+    }
+}
+
+// Walks the tiles crossed by the ray in order, the first solid one is the
+// closest tile hit
+static void cast_tiles(const PreparedRay *r, float dirX, float dirY, const Tilemap *map, RayHit *best) {
+    if(map->cols <= 0 || map->rows <= 0) return;
+    if(!collision_filter_accepts(r->filter, map->category, COLLISION_LAYER_ALL)) return;
+
+    float ts = map->tileSize;
+    float mapMaxX = map->originX + map->cols*ts, mapMaxY = map->originY + map->rows*ts;
+
+    float txNear, txFar, tyNear, tyFar;
+    slab1(r->ox, r->invX, r->zeroX, map->originX, mapMaxX, &txNear, &txFar);
+    slab1(r->oy, r->invY, r->zeroY, map->originY, mapMaxY, &tyNear, &tyFar);
+    float tEnter = fmaxf(fmaxf(txNear, tyNear), 0);
+    float tExit = fminf(fminf(txFar, tyFar), best->distance);
+    if(tEnter > tExit) return;
+
+    float px = r->ox + dirX*tEnter;
+    float py = r->oy + dirY*tEnter;
+    int cx = (int)floorf((px - map->originX)/ts);
+    int cy = (int)floorf((py - map->originY)/ts);
+    if(cx < 0) cx = 0;
+    if(cy < 0) cy = 0;
+    if(cx >= map->cols) cx = map->cols - 1;
+    if(cy >= map->rows) cy = map->rows - 1;
+
+    int stepX = dirX > 0 ? 1 : -1;
+    int stepY = dirY > 0 ? 1 : -1;
+    float tDeltaX = r->zeroX ? INFINITY : fabsf(ts*r->invX);
+    float tDeltaY = r->zeroY ? INFINITY : fabsf(ts*r->invY);
+    float tMaxX = r->zeroX ? INFINITY : (map->originX + (cx + (stepX > 0))*ts - r->ox)*r->invX;
+    float tMaxY = r->zeroY ? INFINITY : (map->originY + (cy + (stepY > 0))*ts - r->oy)*r->invY;
+
+    // the side the ray came in through, none when it starts in the tile
+    float t = tEnter;
+    Vector2 normal = { 0, 0 };
+    if(tEnter > 0) {
+        normal = txNear >= tyNear ? (Vector2){ -r->signX, 0 } : (Vector2){ 0, -r->signY };
+    }
+
+    for(;;) {
+        if(tilemap_get(map, cx, cy)) {
+            if(t < best->distance) {
+                best->distance = t;
+                best->normal = normal;
+                best->collider = (uint32_t)(cy*map->cols + cx) | COLLIDER_REF_TILE;
+            }
+            return;
+        }
+
+        if(tMaxX < tMaxY) {
+            t = tMaxX;
+            cx += stepX;
+            tMaxX += tDeltaX;
+            normal = (Vector2){ -r->signX, 0 };
+            if(cx < 0 || cx >= map->cols) return;
+        } else {
+            t = tMaxY;
+            cy += stepY;
+            tMaxY += tDeltaY;
+            normal = (Vector2){ 0, -r->signY };
+            if(cy < 0 || cy >= map->rows) return;
+        }
+        if(t > tExit) return;
+    }
+}
+
+static RayHit cast_one(const CollisionWorld *world, RayCast ray) {
+    RayHit best = {
+        .distance = ray.maxDistance,
+        .collider = COLLIDER_REF_NONE,
+    };
+
+    float len = sqrtf(ray.dir.x*ray.dir.x + ray.dir.y*ray.dir.y);
+    if(len == 0) return best;
+
+    float dirX = ray.dir.x/len;
+    float dirY = ray.dir.y/len;
+
+    PreparedRay r = {
+        .ox = ray.origin.x,
+        .oy = ray.origin.y,
+        .invX = dirX != 0 ? 1/dirX : 0,
+        .invY = dirY != 0 ? 1/dirY : 0,
+        .signX = dirX < 0 ? -1 : 1,
+        .signY = dirY < 0 ? -1 : 1,
+        .zeroX = dirX == 0,
+        .zeroY = dirY == 0,
+        .filter = ray.filter,
+    };
+
+    // a hit exactly at maxDistance still counts
+    best.distance = nextafterf(ray.maxDistance, INFINITY);
+    cast_dynamic(&r, dirX, dirY, &world->dynamics, &best);
+    cast_static(&r, dirX, dirY, &world->statics, &best);
+    if(world->tiles != NULL) cast_tiles(&r, dirX, dirY, world->tiles, &best);
+    if(best.collider == COLLIDER_REF_NONE) best.distance = ray.maxDistance;
+
+    return best;
+}
+
+RayCast raycast_segment(Vector2 from, Vector2 to, CollisionFilter filter) {
+    Vector2 dir = { to.x - from.x, to.y - from.y };
+    return (RayCast) {
+        .origin = from,
+        .dir = dir,
+        .maxDistance = sqrtf(dir.x*dir.x + dir.y*dir.y),
+        .filter = filter,
+    };
+}
+
+void raycast_batch(const CollisionWorld *world, const RayCast *rays, RayHit *hits, size_t count) {
+    for(size_t i = 0; i < count; i++) {
+        hits[i] = cast_one(world, rays[i]);
+    }
+}
+
+typedef struct {
+    const CollisionWorld *world;
+    const RayCast *rays;
+    RayHit *hits;
+} RaycastJob;
+
+static void raycast_range(void *data, size_t begin, size_t end) {
+    RaycastJob *job = data;
+    raycast_batch(job->world, job->rays + begin, job->hits + begin, end - begin);
+}
+
+void raycast_batch_parallel(JobSystem *js, const CollisionWorld *world, const RayCast *rays, RayHit *hits, size_t count) {
+    RaycastJob job = {
+        .world = world,
+        .rays = rays,
+        .hits = hits,
+    };
+    jobs_parallel_for(js, count, RAYCAST_GRAIN, raycast_range, &job);
+}
@@ -0,0 +1,30 @@
+#ifndef RAYCAST_H
+#define RAYCAST_H
+
+#include "raylib.h"
+#include "collision.h"
+#include "jobs.h"
+
+typedef struct {
+    Vector2 origin;
+    Vector2 dir; // doesn't need to be normalized
+    float maxDistance;
+    CollisionFilter filter;
+} RayCast;
+
+typedef struct {
+    float distance; // maxDistance when nothing was hit
+    Vector2 normal; // zero when the ray starts inside the collider
+    ColliderRef collider; // COLLIDER_REF_NONE when nothing was hit
+} RayHit;
+
+RayCast raycast_segment(Vector2 from, Vector2 to, CollisionFilter filter);
+
+// Casts every ray against the static index, the dynamic colliders and the
+// tiles of the world, hits[i] is the closest hit of rays[i]
+void raycast_batch(const CollisionWorld *world, const RayCast *rays, RayHit *hits, size_t count);
+
+// Same as raycast_batch with the rays split in chunks over the job system
+void raycast_batch_parallel(JobSystem *js, const CollisionWorld *world, const RayCast *rays, RayHit *hits, size_t count);
+
+#endif // RAYCAST_H
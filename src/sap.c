@@ -0,0 +1,172 @@
+#include <stdlib.h>
+
+#include "sap.h"
+#define DA_MEM_TAG MEM_TAG_PHYSICS
+#include "utils.h"
+
+static uint64_t pair_key(uint32_t a, uint32_t b) {
+    return a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a;
+}
+
+static size_t slot_home(const SweepAndPrune *sap, uint64_t key) {
+    // fibonacci hashing, the high bits are the best mixed
+    return (key*0x9e3779b97f4a7c15ull >> 32) & (sap->slotCount - 1);
+}
+
+static size_t slot_find(const SweepAndPrune *sap, uint64_t key) {
+    if(sap->slotCount == 0) return SIZE_MAX;
+
+    size_t mask = sap->slotCount - 1;
+    for(size_t i = slot_home(sap, key);; i = (i + 1) & mask) {
+        if(sap->slots[i].key == key) return i;
+        if(sap->slots[i].key == SAP_SLOT_EMPTY) return SIZE_MAX;
+    }
+}
+
+static void slot_put(SweepAndPrune *sap, SapSlot slot) {
+    size_t mask = sap->slotCount - 1;
+    size_t i = slot_home(sap, slot.key);
+    while(sap->slots[i].key != SAP_SLOT_EMPTY) i = (i + 1) & mask;
+    sap->slots[i] = slot;
+    sap->pairCount++;
+}
+
+static void slots_grow(SweepAndPrune *sap) {
+    SapSlot *old = sap->slots;
+    size_t oldCount = sap->slotCount;
+
+    sap->slotCount = oldCount == 0 ? 256 : oldCount*2;
+    sap->slots = mem_alloc(MEM_TAG_PHYSICS, sap->slotCount*sizeof(SapSlot));
+    assert(sap->slots != NULL && "No enough ram");
+    for(size_t i = 0; i < sap->slotCount; i++) sap->slots[i].key = SAP_SLOT_EMPTY;
+
+    sap->pairCount = 0;
+    for(size_t i = 0; i < oldCount; i++) {
+        if(old[i].key != SAP_SLOT_EMPTY) slot_put(sap, old[i]);
+    }
+    mem_free(old);
+}
+
+// Backward shift deletion, the probe sequences stay valid without tombstones
+static void slot_remove(SweepAndPrune *sap, size_t i) {
+    size_t mask = sap->slotCount - 1;
+    for(size_t j = (i + 1) & mask; sap->slots[j].key != SAP_SLOT_EMPTY; j = (j + 1) & mask) {
+        size_t home = slot_home(sap, sap->slots[j].key);
+        if(((j - home) & mask) >= ((j - i) & mask)) {
+            sap->slots[i] = sap->slots[j];
+            i = j;
+        }
+    }
+    sap->slots[i].key = SAP_SLOT_EMPTY;
+    sap->pairCount--;
+}
+
+void sap_free(SweepAndPrune *sap) {
+    mem_free(sap->bodies);
+    mem_free(sap->endpoints);
+    mem_free(sap->slots);
+    da_free(&sap->added);
+    da_free(&sap->removed);
+    *sap = (SweepAndPrune){0};
+}
+
+uint32_t sap_add(SweepAndPrune *sap, Collider body) {
+    if(sap->count == sap->capacity) {
+        sap->capacity = sap->capacity == 0 ? DA_INIT_CAP : sap->capacity*2;
+        sap->bodies = mem_realloc(MEM_TAG_PHYSICS, sap->bodies, sap->capacity*sizeof(Collider));
+        sap->endpoints = mem_realloc(MEM_TAG_PHYSICS, sap->endpoints, 2*sap->capacity*sizeof(SapEndpoint));
+        assert(sap->bodies != NULL && sap->endpoints != NULL && "No enough ram");
+    }
+
+    // the endpoints start at the end, the next sort moves them in place as
+    // if the body came from the far right
+    uint32_t id = sap->count++;
+    sap->bodies[id] = body;
+    sap->endpoints[2*id] = (SapEndpoint){ .value = body.x, .body = id };
+    sap->endpoints[2*id + 1] = (SapEndpoint){ .value = body.x + body.width, .body = id | SAP_ENDPOINT_MAX };
+    return id;
+}
+
+void sap_set(SweepAndPrune *sap, uint32_t body, Collider collider) {
+    assert(body < sap->count);
+    sap->bodies[body] = collider;
+}
+
+// Ties put the max first, bodies that only touch don't overlap
+static bool endpoint_before(SapEndpoint a, SapEndpoint b) {
+    if(a.value != b.value) return a.value < b.value;
+    return (a.body & SAP_ENDPOINT_MAX) && !(b.body & SAP_ENDPOINT_MAX);
+}
+
+static void begin_x_overlap(SweepAndPrune *sap, uint32_t a, uint32_t b) {
+    uint64_t key = pair_key(a, b);
+    if(slot_find(sap, key) != SIZE_MAX) return;
+
+    if(2*(sap->pairCount + 1) > sap->slotCount) slots_grow(sap);
+    slot_put(sap, (SapSlot){ .key = key, .overlapping = false });
+}
+
+static void end_x_overlap(SweepAndPrune *sap, uint32_t a, uint32_t b) {
+    uint64_t key = pair_key(a, b);
+    size_t slot = slot_find(sap, key);
+    if(slot == SIZE_MAX) return;
+
+    if(sap->slots[slot].overlapping) {
+        da_append(&sap->removed, ((SapPair){ .a = key >> 32, .b = (uint32_t)key }));
+    }
+    slot_remove(sap, slot);
+}
+
+static bool bodies_overlap(Collider a, Collider b) {
+    if(!collision_filter_accepts((CollisionFilter){ a.category, a.mask }, b.category, b.mask)) return false;
+    return a.x < b.x + b.width && a.x + a.width > b.x &&
+           a.y < b.y + b.height && a.y + a.height > b.y;
+}
+
+void sap_update(SweepAndPrune *sap) {
+    sap->added.count = 0;
+    sap->removed.count = 0;
+    sap->swaps = 0;
+
+    size_t endpointCount = 2*sap->count;
+    SapEndpoint *ep = sap->endpoints;
+    for(size_t i = 0; i < endpointCount; i++) {
+        Collider c = sap->bodies[ep[i].body & ~SAP_ENDPOINT_MAX];
+        ep[i].value = ep[i].body & SAP_ENDPOINT_MAX ? c.x + c.width : c.x;
+    }
+
+    // a min going left past a max starts an x overlap, a max going left
+    // past a min ends one
+    for(size_t i = 1; i < endpointCount; i++) {
+        SapEndpoint cur = ep[i];
+        size_t j = i;
+        while(j > 0 && endpoint_before(cur, ep[j - 1])) {
+            SapEndpoint prev = ep[j - 1];
+            uint32_t a = cur.body & ~SAP_ENDPOINT_MAX, b = prev.body & ~SAP_ENDPOINT_MAX;
+            bool curMax = cur.body & SAP_ENDPOINT_MAX, prevMax = prev.body & SAP_ENDPOINT_MAX;
+
+            if(a != b && !curMax && prevMax) begin_x_overlap(sap, a, b);
+            else if(a != b && curMax && !prevMax) end_x_overlap(sap, a, b);
+
+            ep[j] = prev;
+            j--;
+            sap->swaps++;
+        }
+        ep[j] = cur;
+    }
+
+    // the pairs overlapping on x are few, the rest of the test is redone
+    // on all of them since a body can move on y alone
+    for(size_t i = 0; i < sap->slotCount; i++) {
+        SapSlot *slot = &sap->slots[i];
+        if(slot->key == SAP_SLOT_EMPTY) continue;
+
+        SapPair pair = { .a = slot->key >> 32, .b = (uint32_t)slot->key };
+        bool overlapping = bodies_overlap(sap->bodies[pair.a], sap->bodies[pair.b]);
+        if(overlapping == slot->overlapping) continue;
+
+        slot->overlapping = overlapping;
+        if(overlapping) da_append(&sap->added, pair);
+        else da_append(&sap->removed, pair);
+    }
+}
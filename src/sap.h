@@ -0,0 +1,67 @@
+#ifndef SAP_H
+#define SAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "raylib.h"
+#include "collision.h"
+
+// The min and max of a body on the x axis, the high bit of body tells which
+typedef struct {
+    float value;
+    uint32_t body;
+} SapEndpoint;
+
+#define SAP_ENDPOINT_MAX 0x80000000u
+
+typedef struct {
+    uint32_t a; // always the smaller body
+    uint32_t b;
+} SapPair;
+
+typedef struct {
+    SapPair *items;
+    size_t count;
+    size_t capacity;
+} SapPairs;
+
+// Open addressing set of the pairs overlapping on x, with whether they
+// overlap on y too and pass the layers
+typedef struct {
+    uint64_t key;
+    bool overlapping;
+} SapSlot;
+
+#define SAP_SLOT_EMPTY UINT64_MAX
+
+// Sweep and prune broadphase for bodies that all move. The endpoints stay
+// sorted on x between ticks, so with coherent motion the insertion sort of
+// an update only does a few swaps. Each swap starts or ends an x overlap,
+// only those pairs are checked on y.
+typedef struct {
+    Collider *bodies;
+    size_t count;
+    size_t capacity;
+
+    SapEndpoint *endpoints; // 2*count, sorted by value
+    SapSlot *slots;
+    size_t slotCount; // power of two
+    size_t pairCount;
+
+    // what changed during the last sap_update
+    SapPairs added;
+    SapPairs removed;
+    size_t swaps;
+} SweepAndPrune;
+
+void sap_free(SweepAndPrune *sap);
+
+// Returns the id of the body, its pairs show up at the next update
+uint32_t sap_add(SweepAndPrune *sap, Collider body);
+void sap_set(SweepAndPrune *sap, uint32_t body, Collider collider);
+
+// Sorts the endpoints again and fills added and removed with the pairs that
+// started or stopped overlapping since the last update
+void sap_update(SweepAndPrune *sap);
+
+#endif // SAP_H
@@ -0,0 +1,196 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "stream.h"
+#define DA_MEM_TAG MEM_TAG_STREAMING
+#include "utils.h"
+
+void stream_init(ChunkStream *s, StreamConfig config, int cols, int rows, Vector2 origin,
+                 StreamChunkFn load, StreamChunkFn unload, void *user) {
+    *s = (ChunkStream) {
+        .config = config,
+        .originX = origin.x,
+        .originY = origin.y,
+        .cols = cols,
+        .rows = rows,
+        .load = load,
+        .unload = unload,
+        .user = user,
+    };
+
+    size_t count = (size_t)cols*rows;
+    s->state = mem_calloc(MEM_TAG_STREAMING, count, sizeof(uint8_t));
+    s->slot = mem_calloc(MEM_TAG_STREAMING, count, sizeof(uint32_t));
+    assert(s->state != NULL && s->slot != NULL && "No enough ram");
+}
+
+void stream_free(ChunkStream *s) {
+    mem_free(s->state);
+    mem_free(s->slot);
+    da_free(&s->queue);
+    da_free(&s->resident);
+    *s = (ChunkStream){0};
+}
+
+void stream_shift(ChunkStream *s, Vector2 delta) {
+    s->originX += delta.x;
+    s->originY += delta.y;
+}
+
+// Puts r at i or above it, keeping the slots of what it moves
+static void queue_sift_up(ChunkStream *s, size_t i, StreamRequest r) {
+    StreamQueue *q = &s->queue;
+    while(i > 0) {
+        size_t parent = (i - 1)/2;
+        if(q->items[parent].eta <= r.eta) break;
+        q->items[i] = q->items[parent];
+        s->slot[q->items[i].chunk] = (uint32_t)i;
+        i = parent;
+    }
+    q->items[i] = r;
+    s->slot[r.chunk] = (uint32_t)i;
+}
+
+static StreamRequest queue_pop(ChunkStream *s) {
+    StreamQueue *q = &s->queue;
+    StreamRequest top = q->items[0];
+    StreamRequest last = q->items[--q->count];
+    if(q->count == 0) return top;
+
+    size_t i = 0;
+    for(;;) {
+        size_t child = 2*i + 1;
+        if(child >= q->count) break;
+        if(child + 1 < q->count && q->items[child + 1].eta < q->items[child].eta) child++;
+        if(last.eta <= q->items[child].eta) break;
+        q->items[i] = q->items[child];
+        s->slot[q->items[i].chunk] = (uint32_t)i;
+        i = child;
+    }
+    q->items[i] = last;
+    s->slot[last.chunk] = (uint32_t)i;
+
+    return top;
+}
+
+// A queued chunk only moves when it's needed sooner than its request says
+static void request(ChunkStream *s, int cx, int cy, float eta) {
+    if(cx < 0 || cy < 0 || cx >= s->cols || cy >= s->rows) return;
+
+    uint32_t chunk = cy*s->cols + cx;
+    if(s->state[chunk] == CHUNK_RESIDENT) return;
+
+    StreamRequest r = { .eta = eta, .chunk = chunk };
+    if(s->state[chunk] == CHUNK_QUEUED) {
+        size_t i = s->slot[chunk];
+        if(s->queue.items[i].eta > eta) queue_sift_up(s, i, r);
+        return;
+    }
+
+    // refused by the streaming budget, it's asked for again next tick
+    bool ok;
+    da_try_append(&s->queue, r, ok);
+    if(!ok) return;
+
+    s->state[chunk] = CHUNK_QUEUED;
+    queue_sift_up(s, s->queue.count - 1, r);
+}
+
+static void request_box(ChunkStream *s, Rectangle box, float eta) {
+    float cs = s->config.chunkSize;
+    int x0 = (int)floorf((box.x - s->originX)/cs), x1 = (int)floorf((box.x + box.width - s->originX)/cs);
+    int y0 = (int)floorf((box.y - s->originY)/cs), y1 = (int)floorf((box.y + box.height - s->originY)/cs);
+    for(int cy = y0; cy <= y1; cy++) {
+        for(int cx = x0; cx <= x1; cx++) request(s, cx, cy, eta);
+    }
+}
+
+static int chunk_distance(const ChunkStream *s, uint32_t chunk, int px, int py) {
+    int dx = abs((int)(chunk % s->cols) - px);
+    int dy = abs((int)(chunk / s->cols) - py);
+    return dx > dy ? dx : dy;
+}
+
+void stream_update(ChunkStream *s, const Player *player, PlayerInput input, float dt) {
+    float cs = s->config.chunkSize;
+    Rectangle box = player_get_rec(player);
+    Vector2 center = { box.x + box.width/2, box.y + box.height/2 };
+    int px = (int)floorf((center.x - s->originX)/cs);
+    int py = (int)floorf((center.y - s->originY)/cs);
+
+    // what the player is in now should have been loaded already
+    int x0 = (int)floorf((box.x - s->originX)/cs), x1 = (int)floorf((box.x + box.width - s->originX)/cs);
+    int y0 = (int)floorf((box.y - s->originY)/cs), y1 = (int)floorf((box.y + box.height - s->originY)/cs);
+    for(int cy = y0; cy <= y1; cy++) {
+        for(int cx = x0; cx <= x1; cx++) {
+            if(cx < 0 || cy < 0 || cx >= s->cols || cy >= s->rows) continue;
+            if(s->state[cy*s->cols + cx] != CHUNK_RESIDENT) s->misses++;
+        }
+    }
+    request_box(s, box, 0);
+
+    int r = s->config.loadRadius;
+    for(int cy = py - r; cy <= py + r; cy++) {
+        for(int cx = px - r; cx <= px + r; cx++) {
+            float dx = (cx + 0.5f)*cs + s->originX - center.x;
+            float dy = (cy + 0.5f)*cs + s->originY - center.y;
+            request(s, cx, cy, sqrtf(dx*dx + dy*dy)/STREAM_REFERENCE_SPEED);
+        }
+    }
+
+    if(s->config.horizon > 0 && dt > 0) {
+        size_t steps = (size_t)(s->config.horizon/dt);
+        if(steps > STREAM_MAX_PREDICTION) steps = STREAM_MAX_PREDICTION;
+
+        // the floor holds a player that doesn't jump, it falls once it's off
+        // it but that needs the level
+        PlayerArc arc;
+        player_arc(player, input, dt, (int)steps, &arc);
+        bool held = player->isOnFloor && !input.jumpPressed;
+        for(int i = 1; i <= arc.ticks; i++) {
+            Vector2 pos = player_arc_at(&arc, i);
+            if(held) pos.y = player->pos.y;
+            request_box(s, (Rectangle){ pos.x, pos.y, box.width, box.height }, i*dt);
+        }
+    }
+
+    for(int loads = 0; loads < s->config.loadsPerTick && s->queue.count > 0;) {
+        StreamRequest req = queue_pop(s);
+
+        // the player may have turned around since it was queued
+        if(chunk_distance(s, req.chunk, px, py) > s->config.evictRadius) {
+            s->state[req.chunk] = CHUNK_UNLOADED;
+            continue;
+        }
+
+        // no room to remember it over the streaming budget, so it's not loaded
+        bool ok;
+        da_try_append(&s->resident, req.chunk, ok);
+        if(!ok) {
+            s->state[req.chunk] = CHUNK_UNLOADED;
+            break;
+        }
+
+        int cx = req.chunk % s->cols, cy = req.chunk / s->cols;
+        if(s->load != NULL) s->load(s->user, cx, cy);
+        s->state[req.chunk] = CHUNK_RESIDENT;
+        s->loads++;
+        loads++;
+
+        if(cx >= x0 && cx <= x1 && cy >= y0 && cy <= y1) s->lateLoads++;
+        else s->prefetched++;
+    }
+
+    for(size_t i = 0; i < s->resident.count;) {
+        uint32_t chunk = s->resident.items[i];
+        if(chunk_distance(s, chunk, px, py) <= s->config.evictRadius) {
+            i++;
+            continue;
+        }
+
+        if(s->unload != NULL) s->unload(s->user, chunk % s->cols, chunk / s->cols);
+        s->state[chunk] = CHUNK_UNLOADED;
+        s->resident.items[i] = s->resident.items[--s->resident.count];
+        s->evictions++;
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdint.h>
+#include "raylib.h"
+#include "game.h"
+#include "player.h"
+
+#define STREAM_MAX_PREDICTION 240 // ticks of predicted path
+// Speed used to turn the distance of the chunks around the player into a
+// time, so they can be ranked with the ones on the predicted path
+#define STREAM_REFERENCE_SPEED 1000
+
+typedef enum {
+    CHUNK_UNLOADED,
+    CHUNK_QUEUED,
+    CHUNK_RESIDENT,
+} ChunkState;
+
+typedef void (*StreamChunkFn)(void *user, int cx, int cy);
+
+typedef struct {
+    float chunkSize;
+    int loadRadius; // chunks around the player that are always wanted
+    int evictRadius; // resident chunks further than this are unloaded
+    float horizon; // seconds of predicted path to prefetch, 0 streams by distance only
+    int loadsPerTick; // how many chunks can be loaded in a tick
+} StreamConfig;
+
+typedef struct {
+    float eta; // when the player is expected to need the chunk
+    uint32_t chunk;
+} StreamRequest;
+
+// A chunk is in it at most once, a request for a queued chunk that's needed
+// sooner moves it up in place
+typedef struct {
+    StreamRequest *items; // min heap on eta
+    size_t count;
+    size_t capacity;
+} StreamQueue;
+
+typedef struct {
+    uint32_t *items;
+    size_t count;
+    size_t capacity;
+} ChunkList;
+
+// Loads the chunks of a big level before the player gets to them. The ones
+// on the arc player_arc predicts from its velocity, dash and jump come first,
+// sorted by when it will reach them, then the ones around it.
+typedef struct {
+    StreamConfig config;
+    float originX;
+    float originY;
+    int cols;
+    int rows;
+
+    uint8_t *state; // a ChunkState per chunk
+    uint32_t *slot; // where each queued chunk is in the queue
+    StreamQueue queue;
+    ChunkList resident;
+
+    StreamChunkFn load;
+    StreamChunkFn unload;
+    void *user;
+
+    size_t loads;
+    size_t evictions;
+    size_t prefetched; // loaded before the player touched them
+    size_t lateLoads; // loaded while the player was already inside
+    size_t misses; // ticks the player spent in a chunk that wasn't loaded, per chunk
+} ChunkStream;
+
+void stream_init(ChunkStream *s, StreamConfig config, int cols, int rows, Vector2 origin,
+                 StreamChunkFn load, StreamChunkFn unload, void *user);
+void stream_free(ChunkStream *s);
+
+// Moves the grid with the rest of the world on a rebase
+void stream_shift(ChunkStream *s, Vector2 delta);
+
+// Queues what the player will need, loads the most urgent chunks within the
+// budget and unloads the far ones. Call it once per tick with the input the
+// player is stepped with.
+void stream_update(ChunkStream *s, const Player *player, PlayerInput input, float dt);
+
+#endif // STREAM_H
@@ -0,0 +1,159 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "tilemap.h"
+#include "mem.h"
+
+void tilemap_init(Tilemap *map, int cols, int rows, float tileSize, Vector2 origin) {
+    int wordsPerRow = (cols + 63)/64;
+    *map = (Tilemap) {
+        .originX = origin.x,
+        .originY = origin.y,
+        .tileSize = tileSize,
+        .cols = cols,
+        .rows = rows,
+        .wordsPerRow = wordsPerRow,
+        .category = COLLISION_LAYER_SOLID,
+    };
+
+    if(cols > 0 && rows > 0) {
+        map->bits = mem_calloc(MEM_TAG_LEVEL, (size_t)wordsPerRow*rows, sizeof(uint64_t));
+        assert(map->bits != NULL && "No enough ram");
+    }
+}
+
+void tilemap_free(Tilemap *map) {
+    mem_free(map->bits);
+    *map = (Tilemap){0};
+}
+
+void tilemap_load_string(Tilemap *map, const char *layout, float tileSize, Vector2 origin) {
+    int cols = 0, rows = 0, col = 0;
+    for(const char *c = layout; *c != '\0'; c++) {
+        if(*c == '\n') {
+            rows++;
+            col = 0;
+        } else if(++col > cols) {
+            cols = col;
+        }
+    }
+    if(col > 0) rows++;
+
+    tilemap_init(map, cols, rows, tileSize, origin);
+
+    int row = 0;
+    col = 0;
+    for(const char *c = layout; *c != '\0'; c++) {
+        if(*c == '\n') {
+            row++;
+            col = 0;
+            continue;
+        }
+        if(*c == '#') tilemap_set(map, col, row, true);
+        col++;
+    }
+}
+
+void tilemap_shift(Tilemap *map, Vector2 delta) {
+    map->originX += delta.x;
+    map->originY += delta.y;
+}
+
+void tilemap_set(Tilemap *map, int col, int row, bool solid) {
+    assert(col >= 0 && col < map->cols && row >= 0 && row < map->rows);
+    uint64_t *word = &map->bits[(size_t)row*map->wordsPerRow + col/64];
+    uint64_t bit = 1ull << (col % 64);
+    if(solid) *word |= bit;
+    else *word &= ~bit;
+}
+
+bool tilemap_get(const Tilemap *map, int col, int row) {
+    if(col < 0 || col >= map->cols || row < 0 || row >= map->rows) return false;
+    return map->bits[(size_t)row*map->wordsPerRow + col/64] >> (col % 64) & 1;
+}
+
+static Collider run_collider(const Tilemap *map, int row, int start, int end) {
+    return (Collider) {
+        .x = map->originX + start*map->tileSize,
+        .y = map->originY + row*map->tileSize,
+        .width = (end - start)*map->tileSize,
+        .height = map->tileSize,
+        .category = map->category,
+        .mask = COLLISION_LAYER_ALL,
+    };
+}
+
+size_t tilemap_query(const Tilemap *map, Rectangle area, CollisionFilter filter, Collider *out, size_t max) {
+    if(map->bits == NULL) return 0;
+    if(!collision_filter_accepts(filter, map->category, COLLISION_LAYER_ALL)) return 0;
+
+    // tiles are half open, one that only touches area doesn't count
+    float ts = map->tileSize;
+    int c0 = (int)floorf((area.x - map->originX)/ts);
+    int c1 = (int)ceilf((area.x + area.width - map->originX)/ts) - 1;
+    int r0 = (int)floorf((area.y - map->originY)/ts);
+    int r1 = (int)ceilf((area.y + area.height - map->originY)/ts) - 1;
+
+    if(c0 < 0) c0 = 0;
+    if(r0 < 0) r0 = 0;
+    if(c1 >= map->cols) c1 = map->cols - 1;
+    if(r1 >= map->rows) r1 = map->rows - 1;
+    if(c0 > c1 || r0 > r1) return 0;
+
+    size_t found = 0;
+    for(int row = r0; row <= r1; row++) {
+        const uint64_t *words = &map->bits[(size_t)row*map->wordsPerRow];
+        int runStart = -1;
+
+        for(int w = c0/64; w <= c1/64; w++) {
+            uint64_t bits = words[w];
+
+            // keep only the columns inside [c0, c1]
+            int lo = w == c0/64 ? c0 % 64 : 0;
+            int hi = w == c1/64 ? c1 % 64 : 63;
+            bits &= ~0ull << lo;
+            bits &= ~0ull >> (63 - hi);
+
+            if(bits == 0) {
+                if(runStart >= 0) {
+                    if(found == max) return found;
+                    out[found++] = run_collider(map, row, runStart, w*64);
+                    runStart = -1;
+                }
+                continue;
+            }
+
+            int bit = 0;
+            while(bit < 64 && (bits >> bit) != 0) {
+                uint64_t rest = bits >> bit;
+                int start = bit + __builtin_ctzll(rest);
+                uint64_t ones = ~(bits >> start);
+                int end = ones == 0 ? 64 : start + __builtin_ctzll(ones);
+
+                // a run left open by the previous word only goes on at bit 0
+                if(runStart >= 0 && start != 0) {
+                    if(found == max) return found;
+                    out[found++] = run_collider(map, row, runStart, w*64);
+                    runStart = -1;
+                }
+                if(runStart < 0) runStart = w*64 + start;
+
+                if(end < 64) {
+                    if(found == max) return found;
+                    out[found++] = run_collider(map, row, runStart, w*64 + end);
+                    runStart = -1;
+                }
+                bit = end;
+            }
+        }
+
+        if(runStart >= 0) {
+            if(found == max) return found;
+            out[found++] = run_collider(map, row, runStart, c1 + 1);
+        }
+    }
+
+    return found;
+}
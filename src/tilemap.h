@@ -0,0 +1,39 @@
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "raylib.h"
+#include "collision.h"
+
+// Solid tiles of a grid level, one bit per tile. Every row starts at a new
+// 64 bit word so a row can be scanned a word at a time.
+typedef struct Tilemap {
+    float originX;
+    float originY;
+    float tileSize;
+    int cols;
+    int rows;
+    int wordsPerRow;
+    uint64_t *bits;
+
+    uint32_t category; // of every tile, COLLISION_LAYER_SOLID by default
+} Tilemap;
+
+void tilemap_init(Tilemap *map, int cols, int rows, float tileSize, Vector2 origin);
+void tilemap_free(Tilemap *map);
+
+// '#' is a solid tile, anything else is empty, rows are separated by '\n'
+void tilemap_load_string(Tilemap *map, const char *layout, float tileSize, Vector2 origin);
+
+// Moves the whole map, only its origin changes
+void tilemap_shift(Tilemap *map, Vector2 delta);
+
+void tilemap_set(Tilemap *map, int col, int row, bool solid);
+bool tilemap_get(const Tilemap *map, int col, int row);
+
+// Writes the solid tiles under area to out. Consecutive solid tiles of a row
+// come back as a single collider.
+size_t tilemap_query(const Tilemap *map, Rectangle area, CollisionFilter filter, Collider *out, size_t max);
+
+#endif // TILEMAP_H
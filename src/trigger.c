@@ -0,0 +1,90 @@
+#include <stdlib.h>
+
+#include "trigger.h"
+#define DA_MEM_TAG MEM_TAG_PHYSICS
+#include "utils.h"
+
+void trigger_set_add(TriggerSet *set, Rectangle area, TriggerKind kind) {
+    da_append(&set->triggers, ((Trigger){
+        .volume = {
+            .x = area.x,
+            .y = area.y,
+            .width = area.width,
+            .height = area.height,
+            .category = COLLISION_LAYER_TRIGGER,
+            .mask = COLLISION_LAYER_PLAYER | COLLISION_LAYER_ENEMY,
+        },
+        .kind = kind,
+    }));
+}
+
+void trigger_set_build(TriggerSet *set) {
+    Colliders volumes = {0};
+    for(size_t i = 0; i < set->triggers.count; i++) {
+        da_append(&volumes, set->triggers.items[i].volume);
+    }
+
+    static_index_free(&set->index);
+    static_index_build(&set->index, volumes.items, volumes.count);
+    da_free(&volumes);
+}
+
+void trigger_set_free(TriggerSet *set) {
+    static_index_free(&set->index);
+    da_free(&set->triggers);
+    *set = (TriggerSet){0};
+}
+
+void trigger_set_shift(TriggerSet *set, Vector2 delta) {
+    for(size_t i = 0; i < set->triggers.count; i++) {
+        set->triggers.items[i].volume.x += delta.x;
+        set->triggers.items[i].volume.y += delta.y;
+    }
+    static_index_shift(&set->index, delta);
+}
+
+void triggers_begin_tick(TriggerSet *set) {
+    set->eventCount = 0;
+    set->droppedEvents = 0;
+}
+
+static void push_event(TriggerSet *set, TriggerEventType type, uint32_t trigger, uint32_t body) {
+    if(set->eventCount == TRIGGER_MAX_EVENTS) {
+        set->droppedEvents++;
+        return;
+    }
+
+    set->events[set->eventCount++] = (TriggerEvent) {
+        .type = type,
+        .trigger = trigger,
+        .body = body,
+    };
+}
+
+static int compare_indices(const void *a, const void *b) {
+    uint32_t ia = *(const uint32_t*)a, ib = *(const uint32_t*)b;
+    return (ia > ib) - (ia < ib);
+}
+
+void triggers_track(TriggerSet *set, TriggerTracker *tracker, Rectangle box, CollisionFilter filter, uint32_t body) {
+    uint32_t current[TRIGGER_MAX_OVERLAPS];
+    size_t count = static_index_query(&set->index, box, filter, current, TRIGGER_MAX_OVERLAPS);
+    for(size_t i = 0; i < count; i++) current[i] = set->index.source[current[i]];
+    qsort(current, count, sizeof(uint32_t), compare_indices);
+
+    // both lists are sorted, walk them together
+    size_t p = 0, c = 0;
+    while(p < tracker->count || c < count) {
+        if(c == count || (p < tracker->count && tracker->overlaps[p] < current[c])) {
+            push_event(set, TRIGGER_EXIT, tracker->overlaps[p++], body);
+        } else if(p == tracker->count || current[c] < tracker->overlaps[p]) {
+            push_event(set, TRIGGER_ENTER, current[c++], body);
+        } else {
+            push_event(set, TRIGGER_STAY, current[c++], body);
+            p++;
+        }
+    }
+
+    for(size_t i = 0; i < count; i++) tracker->overlaps[i] = current[i];
+    tracker->count = count;
+}
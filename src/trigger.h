@@ -0,0 +1,71 @@
+#ifndef TRIGGER_H
+#define TRIGGER_H
+
+#include <stdint.h>
+#include "raylib.h"
+#include "collision.h"
+
+#define TRIGGER_MAX_OVERLAPS 32 // triggers a single body can be inside of
+#define TRIGGER_MAX_EVENTS 128 // per tick, the rest are counted as dropped
+
+typedef enum {
+    TRIGGER_CHECKPOINT,
+    TRIGGER_HAZARD,
+    TRIGGER_ROOM,
+} TriggerKind;
+
+typedef struct {
+    Collider volume;
+    TriggerKind kind;
+} Trigger;
+
+typedef struct {
+    Trigger *items;
+    size_t count;
+    size_t capacity;
+} Triggers;
+
+typedef enum {
+    TRIGGER_ENTER,
+    TRIGGER_STAY,
+    TRIGGER_EXIT,
+} TriggerEventType;
+
+typedef struct {
+    TriggerEventType type;
+    uint32_t trigger; // index in TriggerSet.triggers
+    uint32_t body; // whatever the caller passed to triggers_track
+} TriggerEvent;
+
+// Non solid volumes that fire events. They are indexed like the static
+// colliders and the events of a tick are queued in a fixed buffer.
+typedef struct {
+    Triggers triggers;
+    StaticIndex index;
+
+    TriggerEvent events[TRIGGER_MAX_EVENTS];
+    size_t eventCount;
+    size_t droppedEvents;
+} TriggerSet;
+
+// The triggers a body was inside of last tick, sorted
+typedef struct {
+    uint32_t overlaps[TRIGGER_MAX_OVERLAPS];
+    size_t count;
+} TriggerTracker;
+
+void trigger_set_add(TriggerSet *set, Rectangle area, TriggerKind kind);
+// Call it after adding the triggers and before tracking anything
+void trigger_set_build(TriggerSet *set);
+void trigger_set_free(TriggerSet *set);
+// Moves every volume, the trackers stay valid
+void trigger_set_shift(TriggerSet *set, Vector2 delta);
+
+// Empties the event queue, once per tick before tracking the bodies
+void triggers_begin_tick(TriggerSet *set);
+
+// Finds the triggers overlapping box and queues the enter, stay and exit
+// events by diffing them against what the tracker saw last tick.
+void triggers_track(TriggerSet *set, TriggerTracker *tracker, Rectangle box, CollisionFilter filter, uint32_t body);
+
+#endif // TRIGGER_H
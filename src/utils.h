@@ -3,20 +3,45 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include "mem.h"
 
 #define DA_INIT_CAP 16
 
-#define da_append(da, item)                                                          \
-    do {                                                                             \
-        if((da)->count >= (da)->capacity) {                                          \
-            (da)->capacity = (da)->capacity == 0 ? DA_INIT_CAP : (da)->capacity*2;   \
-            (da)->items = realloc((da)->items, (da)->capacity*sizeof(*(da)->items)); \
-            assert((da)->items != NULL && "No enough ram");                          \
-        }                                                                            \
-                                                                                     \
-        (da)->items[(da)->count++] = (item);                                         \
+// What the arrays grown by da_append in a file are counted as, define it
+// before including utils.h
+#ifndef DA_MEM_TAG
+#define DA_MEM_TAG MEM_TAG_SCRATCH
+#endif
+
+#define da_append(da, item)                                                                          \
+    do {                                                                                             \
+        if((da)->count >= (da)->capacity) {                                                          \
+            (da)->capacity = (da)->capacity == 0 ? DA_INIT_CAP : (da)->capacity*2;                   \
+            (da)->items = mem_realloc(DA_MEM_TAG, (da)->items, (da)->capacity*sizeof(*(da)->items)); \
+            assert((da)->items != NULL && "No enough ram");                                          \
+        }                                                                                            \
+                                                                                                     \
+        (da)->items[(da)->count++] = (item);                                                         \
+    } while(0)
+
+// For the tags whose budget may refuse: ok is set to false and the array is
+// left as it was instead of aborting
+#define da_try_append(da, item, ok)                                                              \
+    do {                                                                                         \
+        (ok) = true;                                                                             \
+        if((da)->count >= (da)->capacity) {                                                      \
+            size_t da_cap = (da)->capacity == 0 ? DA_INIT_CAP : (da)->capacity*2;                \
+            void *da_items = mem_realloc(DA_MEM_TAG, (da)->items, da_cap*sizeof(*(da)->items)); \
+            if(da_items == NULL) {                                                               \
+                (ok) = false;                                                                    \
+            } else {                                                                             \
+                (da)->items = da_items;                                                          \
+                (da)->capacity = da_cap;                                                         \
+            }                                                                                    \
+        }                                                                                        \
+        if(ok) (da)->items[(da)->count++] = (item);                                              \
     } while(0)
 
-#define da_free(da) do { free((da)->items); } while(0)
+#define da_free(da) do { mem_free((da)->items); } while(0)
 
 #endif // UTILS_H
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "../src/level.h"
+#include "../src/utils.h"
+
+// Turns a level source into a header of static const tables: the platforms
+// to draw and the merged colliders already indexed, so a built-in level
+// costs nothing at startup and lives in the read only data of the binary.
+//
+//     levelgen <name> <source.lvl> <output.h>
+
+typedef struct {
+    Rectangle *items;
+    size_t count;
+    size_t capacity;
+} Rects;
+
+static bool parse_level(const char *path, Rects *out) {
+    FILE *f = fopen(path, "r");
+    if(f == NULL) {
+        fprintf(stderr, "levelgen: can't open %s\n", path);
+        return false;
+    }
+
+    char line[256];
+    int lineNumber = 0;
+    bool ok = true;
+    while(fgets(line, sizeof(line), f) != NULL) {
+        lineNumber++;
+
+        char *c = line;
+        while(isspace((unsigned char)*c)) c++;
+        if(*c == '\0' || *c == '#') continue;
+
+        Rectangle r;
+        char extra;
+        if(sscanf(c, "platform %f %f %f %f %c", &r.x, &r.y, &r.width, &r.height, &extra) != 4 ||
+           r.width <= 0 || r.height <= 0) {
+            fprintf(stderr, "%s:%d: expected platform x y width height\n", path, lineNumber);
+            ok = false;
+            break;
+        }
+        da_append(out, r);
+    }
+
+    fclose(f);
+    return ok;
+}
+
+// 9 significant digits are enough for any float to come back the same
+static void write_floats(FILE *f, const char *prefix, const char *name, const float *values, size_t count) {
+    fprintf(f, "static const float %s_%s[] = {", prefix, name);
+    for(size_t i = 0; i < count; i++) {
+        fprintf(f, "%s%.9g,", i % 8 == 0 ? "\n    " : " ", values[i]);
+    }
+    fprintf(f, count == 0 ? " 0 };\n\n" : "\n};\n\n");
+}
+
+static void write_u32s(FILE *f, const char *prefix, const char *name, const uint32_t *values, size_t count) {
+    fprintf(f, "static const uint32_t %s_%s[] = {", prefix, name);
+    for(size_t i = 0; i < count; i++) {
+        fprintf(f, "%s0x%x,", i % 8 == 0 ? "\n    " : " ", values[i]);
+    }
+    fprintf(f, count == 0 ? " 0 };\n\n" : "\n};\n\n");
+}
+
+static void write_header(FILE *f, const char *name, const char *source, const Rects *platforms, const StaticIndex *index) {
+    char prefix[64], guard[64];
+    snprintf(prefix, sizeof(prefix), "level_%s", name);
+    size_t i = 0;
+    for(; prefix[i] != '\0'; i++) guard[i] = toupper((unsigned char)prefix[i]);
+    guard[i] = '\0';
+
+    fprintf(f, "// Generated by tools/levelgen.c from %s, edit that one instead\n", source);
+    fprintf(f, "#ifndef %s_H\n#define %s_H\n\n", guard, guard);
+    fprintf(f, "#include <stdint.h>\n#include \"../collision.h\"\n\n");
+
+    fprintf(f, "#define %s_PLATFORM_COUNT %zu\n\n", guard, platforms->count);
+    fprintf(f, "static const Rectangle %s_platforms[] = {\n", prefix);
+    for(i = 0; i < platforms->count; i++) {
+        Rectangle r = platforms->items[i];
+        fprintf(f, "    { %.9g, %.9g, %.9g, %.9g },\n", r.x, r.y, r.width, r.height);
+    }
+    if(platforms->count == 0) fprintf(f, "    { 0 },\n");
+    fprintf(f, "};\n\n");
+
+    size_t count = index->count;
+    write_floats(f, prefix, "minX", index->minX, count);
+    write_floats(f, prefix, "minY", index->minY, count);
+    write_floats(f, prefix, "maxX", index->maxX, count);
+    write_floats(f, prefix, "maxY", index->maxY, count);
+    write_u32s(f, prefix, "category", index->category, count);
+    write_u32s(f, prefix, "mask", index->mask, count);
+    write_u32s(f, prefix, "source", index->source, count);
+    write_u32s(f, prefix, "position", index->position, count);
+
+    for(int l = 0; l < index->levelCount; l++) {
+        const StaticGrid *grid = &index->levels[l];
+        size_t cells = (size_t)grid->cols*grid->rows;
+        char field[32];
+        snprintf(field, sizeof(field), "cellStart%d", l);
+        write_u32s(f, prefix, field, grid->cellStart, cells + 1);
+        snprintf(field, sizeof(field), "cellItems%d", l);
+        write_u32s(f, prefix, field, grid->cellItems, grid->cellStart[cells]);
+    }
+
+    // no memory: the index doesn't own the tables and never frees them
+    fprintf(f, "static const StaticIndex %s_index = {\n", prefix);
+    const char *fields[] = { "minX", "minY", "maxX", "maxY", "category", "mask", "source", "position" };
+    for(i = 0; i < sizeof(fields)/sizeof(fields[0]); i++) {
+        fprintf(f, "    .%s = %s_%s,\n", fields[i], prefix, fields[i]);
+    }
+    fprintf(f, "    .count = %zu,\n", count);
+    fprintf(f, "    .originX = %.9g,\n    .originY = %.9g,\n", index->originX, index->originY);
+    fprintf(f, "    .levels = {\n");
+    for(int l = 0; l < index->levelCount; l++) {
+        const StaticGrid *grid = &index->levels[l];
+        fprintf(f, "        { %.9g, %d, %d, %s_cellStart%d, %s_cellItems%d },\n",
+                grid->cellSize, grid->cols, grid->rows, prefix, l, prefix, l);
+    }
+    fprintf(f, "    },\n");
+    fprintf(f, "    .levelCount = %d,\n", index->levelCount);
+    fprintf(f, "};\n\n");
+
+    fprintf(f, "#endif // %s_H\n", guard);
+}
+
+int main(int argc, char **argv) {
+    if(argc != 4) {
+        fprintf(stderr, "usage: %s <name> <source.lvl> <output.h>\n", argv[0]);
+        return 1;
+    }
+
+    Rects platforms = {0};
+    if(!parse_level(argv[2], &platforms)) return 1;
+
+    Colliders colliders = {0};
+    level_merge_rects(&colliders, platforms.items, platforms.count);
+    StaticIndex index;
+    static_index_build(&index, colliders.items, colliders.count);
+
+    FILE *f = fopen(argv[3], "w");
+    if(f == NULL) {
+        fprintf(stderr, "levelgen: can't write %s\n", argv[3]);
+        return 1;
+    }
+    write_header(f, argv[1], argv[2], &platforms, &index);
+    bool ok = fclose(f) == 0;
+
+    static_index_free(&index);
+    da_free(&colliders);
+    da_free(&platforms);
+    return ok ? 0 : 1;
+}